@@ -37,8 +37,8 @@ private:
 
 template<ParserType T>
 const ParserSettings &CliParser::parse() {
-  static_assert(T == Tuner || T == Engine);
-  if constexpr (T == Tuner)
+  static_assert(T == ParserType::Tuner || T == ParserType::Engine);
+  if constexpr (T == ParserType::Tuner)
   {
     auto *const file_option = app_.add_option("-f,--file", parser_settings_.file_name, "The PGN file to read as input");
     auto *const pawn_option   = app_.add_flag("-p, --pawn", parser_settings_.pawn, "Enables pawn tuning.");
@@ -83,7 +83,7 @@ const ParserSettings &CliParser::parse() {
     parser_settings_.tempo        = !tempo_option->empty();
     parser_settings_.lazy_margin  = !lazy_option->empty();
 
-  } else if constexpr (T == Engine)
+  } else if constexpr (T == ParserType::Engine)
   {}
 
   return parser_settings_;
@@ -93,11 +93,11 @@ namespace cli {
 
 std::unique_ptr<ParserSettings> make_parser(const int argc, char **argv, const std::string &title, const ParserType type) {
 
-  if (type == Tuner)
-    return std::make_unique<ParserSettings>(CliParser(argc, argv, title).parse<Tuner>());
+  if (type == ParserType::Tuner)
+    return std::make_unique<ParserSettings>(CliParser(argc, argv, title).parse<ParserType::Tuner>());
 
-  if (type == Engine)
-    return std::make_unique<ParserSettings>(CliParser(argc, argv, title).parse<Engine>());
+  if (type == ParserType::Engine)
+    return std::make_unique<ParserSettings>(CliParser(argc, argv, title).parse<ParserType::Engine>());
 
   exit(1);
 }
@@ -23,7 +23,7 @@
 #include <memory>
 #include <string>
 
-enum ParserType { Tuner, Engine };
+enum class ParserType { Tuner, Engine };
 
 struct ParserSettings {
   std::string file_name{};
@@ -10,4 +10,9 @@ function(enable_engine_options)
         add_definitions("-DNO_PREFETCH")
     endif()
 
+    option(TT_STATS "Gather transposition table statistics, shown by the hashstats command" OFF)
+    if (TT_STATS)
+        add_definitions("-DTT_STATS")
+    endif()
+
 endfunction()
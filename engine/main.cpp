@@ -24,7 +24,6 @@
 #include "../src/bitboard.hpp"
 #include "../src/board.hpp"
 #include "../src/uci.hpp"
-#include "../src/transpositional.hpp"
 #include "../src/polyglot.hpp"
 #include "../io/directory_resolver.hpp"
 #include "../io/settings_resolver.hpp"
@@ -49,7 +48,5 @@ int main(const int argc, char *argv[])
 
   uci::init(Options, f);
 
-  TT.init(1);
-
   uci::run(argc, argv);
 }
\ No newline at end of file
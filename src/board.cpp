@@ -18,6 +18,7 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cassert>
 #include <string>
 #include <cctype>
 
@@ -28,7 +29,6 @@
 #include "board.hpp"
 #include "bitboard.hpp"
 #include "util.hpp"
-#include "transpositional.hpp"
 #include "miscellaneous.hpp"
 #include "prng.hpp"
 #include "moves.hpp"
@@ -178,11 +178,20 @@ void update_key(Position *pos, const Move m)
 
 }   // namespace
 
-Board::Board() : position_list({})
+Board::Board(const std::size_t game_plies) : position_list(game_plies + search_positions)
 {
   pos = position_list.data();
 }
 
+void Board::set_game_length(const std::size_t game_plies)
+{
+  if (const auto count = game_plies + search_positions; count > position_list.size())
+  {
+    position_list.resize(count);
+    pos = position_list.data();
+  }
+}
+
 void Board::init()
 {
   for (const auto side : Colors)
@@ -345,7 +354,22 @@ bool Board::is_pseudo_legal(const Move m) const
 
   const auto pt = type_of(move_piece(m));
 
-  return !util::in_between<QUEEN, BISHOP>(pt) || !(between(from, to) & pieces());
+  // The hash move is only verified by a part of the key, so it must also match the geometry of the piece
+  if (pt != PAWN)
+    return !is_promotion(m) && (piece_attacks_bb(pt, from, pieces()) & to);
+
+  if (is_promotion(m) != (relative_rank(move_stm, to) == RANK_8))
+    return false;
+
+  if (is_capture(m))
+    return pawn_attacks_bb(move_stm, from) & to;
+
+  const auto up = pawn_push(move_stm);
+
+  if (type_of(m) & DOUBLEPUSH)
+    return relative_rank(move_stm, from) == RANK_2 && to == from + up + up && !(pieces() & (from + up));
+
+  return to == from + up;
 }
 
 void Board::print() const
@@ -415,6 +439,8 @@ bool Board::make_move(const Move m, const bool check_legal, const bool calculate
   const auto from = move_from(m);
   const auto to   = move_to(m);
 
+  assert(pos + 1 < position_list.data() + position_list.size());
+
   auto *const prev       = pos++;
 
   pos->previous          = prev;
@@ -445,8 +471,6 @@ bool Board::make_move(const Move m, const bool check_legal, const bool calculate
 
   update_key(pos, m);
 
-  prefetch(TT.find_bucket(pos->key));
-
   pos->material.make_move(m);
   pos->pinned = pinned_pieces(pos->side_to_move, ksq);
 
@@ -466,8 +490,86 @@ void Board::unmake_move()
   pos--;
 }
 
+/// key_after() returns the key of the position after m without making the move,
+/// it mirrors the incremental update done by make_move() and make_null_move()
+
+Key Board::key_after(const Move m) const
+{
+  auto key = pos->key ^ zobrist.side();
+
+  [[unlikely]]
+  if (pos->en_passant_square != NO_SQ)
+    key ^= zobrist.ep(file_of(pos->en_passant_square));
+
+  [[unlikely]]
+  if (!m)
+    return key;
+
+  const auto piece = move_piece(m);
+  const auto from  = move_from(m);
+  const auto to    = move_to(m);
+  const auto mt    = type_of(m);
+
+  key ^= zobrist.pst(piece, from) ^ zobrist.pst(mt & PROMOTION ? move_promoted(m) : piece, to);
+
+  [[unlikely]]
+  if (mt & EPCAPTURE)
+    key ^= zobrist.pst(move_captured(m), to + pawn_push(~pos->side_to_move));
+  else if (mt & CAPTURE)
+    key ^= zobrist.pst(move_captured(m), to);
+
+  [[unlikely]]
+  if (mt & DOUBLEPUSH)
+    key ^= zobrist.ep(file_of(to));
+
+  if (can_castle() && (castle_rights_mask[from] | castle_rights_mask[to]))
+    key ^= zobrist.castle(pos->castle_rights)
+         ^ zobrist.castle(pos->castle_rights & ~(castle_rights_mask[from] | castle_rights_mask[to]));
+
+  [[unlikely]]
+  if (mt & CASTLE)
+  {
+    const auto rook = make_piece(ROOK, move_side(m));
+    key ^= zobrist.pst(rook, rook_castles_from[to]) ^ zobrist.pst(rook, rook_castles_to[to]);
+  }
+
+  return key;
+}
+
+Key Board::pawn_key_after(const Move m) const
+{
+  auto pawn_key = pos->pawn_structure_key ^ zobrist.side();
+
+  [[unlikely]]
+  if (!m)
+    return pawn_key;
+
+  const auto piece = move_piece(m);
+  const auto to    = move_to(m);
+  const auto mt    = type_of(m);
+
+  [[likely]]
+  if (type_of(piece) == PAWN)
+  {
+    pawn_key ^= zobrist.pst(piece, move_from(m));
+
+    if (!(mt & PROMOTION))
+      pawn_key ^= zobrist.pst(piece, to);
+
+    [[unlikely]]
+    if (mt & EPCAPTURE)
+      pawn_key ^= zobrist.pst(move_captured(m), to + pawn_push(~pos->side_to_move));
+    else if (mt & CAPTURE)
+      pawn_key ^= zobrist.pst(move_captured(m), to);
+  }
+
+  return pawn_key;
+}
+
 bool Board::make_null_move()
 {
+  assert(pos + 1 < position_list.data() + position_list.size());
+
   auto *const prev                = pos++;
   pos->previous                   = prev;
   pos->side_to_move               = ~prev->side_to_move;
@@ -22,6 +22,7 @@
 
 #include <cstdint>
 #include <array>
+#include <vector>
 #include <optional>
 
 #include "types.hpp"
@@ -33,9 +34,17 @@ enum Move : std::uint32_t;
 
 struct Board
 {
-  using PositionList = std::array<Position, 4096>;
+  using PositionList = std::vector<Position>;
 
-  Board();
+  /// Positions kept above the root for the search, the depth checks of the search stop before MAXDEPTH
+  static constexpr std::size_t search_positions = MAXDEPTH + 2;
+
+  /// The position stack holds the given number of moves of a game and the search from the last of them
+  explicit Board(std::size_t game_plies = 0);
+
+  /// set_game_length() makes room for a game of the given number of moves. The positions can move, so the board
+  /// must be set up again with set_fen() afterwards.
+  void set_game_length(std::size_t game_plies);
 
   static void init();
 
@@ -157,6 +166,12 @@ struct Board
   [[nodiscard]]
   Key key() const;
 
+  [[nodiscard]]
+  Key key_after(Move m) const;
+
+  [[nodiscard]]
+  Key pawn_key_after(Move m) const;
+
   [[nodiscard]]
   Material &material() const;
 
@@ -195,6 +210,18 @@ struct Board
   [[nodiscard]]
   Square king_to() const;
 
+  /// is_king_path_attacked() tells if the king passes or lands on a square attacked by the opponent when castling
+  template<CastlingRight Cr, Color C>
+  [[nodiscard]]
+  bool is_king_path_attacked() const;
+
+  /// bytes() returns the size of the board including its position stack
+  [[nodiscard]]
+  std::size_t bytes() const noexcept
+  {
+    return sizeof(Board) + position_list.size() * sizeof(Position);
+  }
+
   Position *pos;
   int plies{};
   int max_ply{};
@@ -466,3 +493,15 @@ inline Square Board::king_to() const {
   else
     return ooo_king_to[C];
 }
+
+template<CastlingRight Cr, Color C>
+inline bool Board::is_king_path_attacked() const {
+  // castling is not generated when in check, so the square the king starts on is not attacked
+  auto path = between(king_from<Cr, C>(), king_to<Cr, C>()) | king_to<Cr, C>();
+
+  while (path)
+    if (is_attacked(pop_lsb(&path), ~C))
+      return true;
+
+  return false;
+}
@@ -0,0 +1,90 @@
+/*
+  Feliscatus, a UCI chess playing engine derived from Tomcat 1.0 (Bobcat 8.0)
+  Copyright (C) 2008-2016 Gunnar Harms (Bobcat author)
+  Copyright (C) 2017      FireFather (Tomcat author)
+  Copyright (C) 2020-2022 Rudy Alex Kohn
+
+  Feliscatus is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Feliscatus is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <utility>
+
+#include "engine.hpp"
+
+Engine::Engine(const EngineConfig &config) : pool(tt)
+{
+  pool.config = config;
+  pool.set(config.threads);
+  pool.clear_data();
+}
+
+Engine::~Engine()
+{
+  // an infinite search or ponder search only ends when it is told to
+  stop();
+  pool.main()->wait_for_search_finished();
+}
+
+void Engine::configure(const EngineConfig &new_config)
+{
+  pool.main()->wait_for_search_finished();
+
+  const auto old_config = std::exchange(pool.config, new_config);
+
+  pool.set(new_config.threads);
+
+  if (new_config.eval_cache_mb != old_config.eval_cache_mb)
+    for (auto &t : pool)
+      t->eval_cache.resize(new_config.eval_cache_mb);
+
+  if (new_config.pawn_hash_mb != old_config.pawn_hash_mb)
+    for (auto &t : pool)
+      t->pawn_hash.resize(new_config.pawn_hash_mb);
+}
+
+void Engine::new_game()
+{
+  pool.main()->wait_for_search_finished();
+  tt.clear_async();
+  pool.clear_data();
+}
+
+void Engine::start(const std::string_view fen, const SearchLimits &limits)
+{
+  pool.main()->wait_for_search_finished();
+  pool.limits = limits;
+  pool.start_thinking(fen);
+}
+
+SearchResult Engine::wait()
+{
+  pool.main()->wait_for_search_finished();
+  return pool.result;
+}
+
+void Engine::stop()
+{
+  pool.request_stop();
+}
+
+void Engine::ponder_hit()
+{
+  pool.main()->ponder_hit();
+}
+
+SearchResult Engine::search(const std::string_view fen, const SearchLimits &limits)
+{
+  start(fen, limits);
+  return wait();
+}
@@ -0,0 +1,72 @@
+/*
+  Feliscatus, a UCI chess playing engine derived from Tomcat 1.0 (Bobcat 8.0)
+  Copyright (C) 2008-2016 Gunnar Harms (Bobcat author)
+  Copyright (C) 2017      FireFather (Tomcat author)
+  Copyright (C) 2020-2022 Rudy Alex Kohn
+
+  Feliscatus is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Feliscatus is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string_view>
+
+#include "engine_config.hpp"
+#include "search_limits.hpp"
+#include "tpool.hpp"
+#include "transpositional.hpp"
+
+/// One search instance with its own hash table and threads. Several engines can search at the same time in
+/// one process, they only share read-only data such as the attack tables and the opening book.
+/// Board::init() and bitboard::init() must have been called before the first engine is created.
+struct Engine final
+{
+  explicit Engine(const EngineConfig &config = {});
+  ~Engine();
+  Engine(const Engine &other) = delete;
+  Engine(Engine &&other)      = delete;
+  Engine &operator=(const Engine &) = delete;
+  Engine &operator=(Engine &&other) = delete;
+
+  /// configure() applies a new configuration, the threads and tables are only rebuilt where it differs
+  void configure(const EngineConfig &new_config);
+
+  [[nodiscard]]
+  const EngineConfig &config() const noexcept
+  {
+    return pool.config;
+  }
+
+  /// new_game() clears the hash table and the search data of the threads
+  void new_game();
+
+  /// start() starts searching the position and returns at once
+  void start(std::string_view fen, const SearchLimits &limits);
+
+  /// wait() blocks until the search has ended and returns its result
+  SearchResult wait();
+
+  /// stop() ends a running search, wait() still has to be called for the result
+  void stop();
+
+  /// ponder_hit() makes a running ponder search search for the move, with its time counted from now
+  void ponder_hit();
+
+  /// search() searches the position and returns the result when done
+  SearchResult search(std::string_view fen, const SearchLimits &limits);
+
+  // the table is declared first, so it outlives the threads that use it
+  HashTable tt;
+  thread_pool pool;
+};
@@ -0,0 +1,46 @@
+/*
+  Feliscatus, a UCI chess playing engine derived from Tomcat 1.0 (Bobcat 8.0)
+  Copyright (C) 2008-2016 Gunnar Harms (Bobcat author)
+  Copyright (C) 2017      FireFather (Tomcat author)
+  Copyright (C) 2020-2022 Rudy Alex Kohn
+
+  Feliscatus is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Feliscatus is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/// The most lines the MultiPV option allows, there are never more legal moves in a position
+constexpr std::size_t MaxMultiPv = 256;
+
+/// The configuration of one engine instance. The UCI front end fills it from its options,
+/// other users of the library set it directly.
+struct EngineConfig final
+{
+  std::size_t threads{1};
+  std::size_t hash_mb{16};
+  bool hash_x_threads{};
+  std::size_t eval_cache_mb{1};
+  std::size_t pawn_hash_mb{2};
+  std::string thread_binding{"off"};
+  bool skip_depths{};
+  bool ordering_noise{};
+  std::size_t multi_pv{1};   // the number of best root moves searched and reported with their own line
+  bool use_book{};
+  bool book_best_move{};
+  bool show_cpu{};
+  bool uci_output{};   // print info lines and the best move on stdout while searching
+};
@@ -28,6 +28,7 @@
 #include "types.hpp"
 #include "board.hpp"
 #include "parameters.hpp"
+#include "tpool.hpp"
 
 namespace
 {
@@ -75,6 +76,19 @@ struct Evaluate
   template<Color Us>
   int evaluate(int alpha, int beta);
 
+  /// Returns true if the evaluation stopped at the lazy threshold
+  [[nodiscard]]
+  bool is_lazy() const noexcept
+  {
+    return lazy_;
+  }
+
+  [[nodiscard]]
+  int lazy_eval() const noexcept
+  {
+    return lazy_eval_;
+  }
+
 private:
   template<PieceType Pt, Color Us>
   void set_attacks(Bitboard attacks);
@@ -111,6 +125,8 @@ private:
   std::array<int, COL_NB> attack_count{};
   Bitboard piece_attacks[COL_NB][PIECETYPE_NB]{};
   std::array<Bitboard, COL_NB> king_area{};
+  bool lazy_{};
+  int lazy_eval_{};
 
 };
 
@@ -132,7 +148,11 @@ int Evaluate<Tuning>::evaluate(const int alpha, const int beta)
 
   if (const auto lazy_eval = Us == WHITE ? mat_eval : -mat_eval;
       lazy_eval - params::lazy_margin > beta || lazy_eval + params::lazy_margin < alpha)
+  {
+    lazy_      = true;
+    lazy_eval_ = lazy_eval;
     return b->material().evaluate<Us>(b->flags(), lazy_eval, b);
+  }
 
 #endif
 
@@ -388,8 +408,36 @@ namespace Eval
 
 int evaluate(Board *b, const std::size_t pool_index, const int alpha, const int beta)
 {
-  return b->side_to_move() == WHITE ? Evaluate<false>(b, pool_index).evaluate<WHITE>(alpha, beta)
-                                    : Evaluate<false>(b, pool_index).evaluate<BLACK>(alpha, beta);
+  auto &cache  = b->my_thread()->eval_cache;
+  auto *cached = cache[b->key()];
+
+  if (cached)
+  {
+    ++cache.probes;
+
+    // a lazy value is only valid if the current window would also have stopped at the threshold
+    if (
+      cached->key == b->key()
+      && (!cached->lazy || cached->lazy_eval - params::lazy_margin > beta || cached->lazy_eval + params::lazy_margin < alpha))
+    {
+      ++cache.hits;
+      b->flags() = cached->flags;
+      return cached->value;
+    }
+  }
+
+  Evaluate<false> e(b, pool_index);
+  const auto value = b->side_to_move() == WHITE ? e.evaluate<WHITE>(alpha, beta) : e.evaluate<BLACK>(alpha, beta);
+
+  if (cached)
+    *cached = {
+      .key       = b->key(),
+      .value     = value,
+      .lazy_eval = static_cast<std::int16_t>(e.lazy_eval()),
+      .flags     = static_cast<std::uint8_t>(b->flags()),
+      .lazy      = e.is_lazy()};
+
+  return value;
 }
 
 int tune(Board *b, const std::size_t pool_index, const int alpha, const int beta)
@@ -0,0 +1,80 @@
+/*
+  Feliscatus, a UCI chess playing engine derived from Tomcat 1.0 (Bobcat 8.0)
+  Copyright (C) 2008-2016 Gunnar Harms (Bobcat author)
+  Copyright (C) 2017      FireFather (Tomcat author)
+  Copyright (C) 2020-2022 Rudy Alex Kohn
+
+  Feliscatus is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Feliscatus is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "types.hpp"
+
+/// Static evaluations of recently seen positions, kept apart from the transposition table so they do not compete
+/// with search results for slots. Each search thread owns its own cache, so no synchronization is needed.
+struct EvalCacheEntry final
+{
+  Key key{};
+  std::int32_t value{};
+  std::int16_t lazy_eval{};   // material only evaluation, when the value was returned by the lazy threshold
+  std::uint8_t flags{};
+  bool lazy{};
+};
+
+struct EvalCache final
+{
+  void resize(std::size_t size_mb);
+
+  /// Returns the slot for the key, or nullptr if the cache is disabled
+  [[nodiscard]]
+  EvalCacheEntry *operator[](const Key key) noexcept
+  {
+    return table_.empty() ? nullptr : &table_[key & mask_];
+  }
+
+  [[nodiscard]]
+  std::size_t size_mb() const noexcept
+  {
+    return bytes() / (1024 * 1024);
+  }
+
+  [[nodiscard]]
+  std::size_t bytes() const noexcept
+  {
+    return table_.size() * sizeof(EvalCacheEntry);
+  }
+
+  std::uint64_t probes{};
+  std::uint64_t hits{};
+
+private:
+  std::vector<EvalCacheEntry> table_{};
+  std::size_t mask_{};
+};
+
+inline void EvalCache::resize(const std::size_t size_mb)
+{
+  // keep the number of entries a power of two so the index is a simple mask
+  const auto entries = size_mb * 1024 * 1024 / sizeof(EvalCacheEntry);
+  const auto count   = entries ? std::bit_floor(entries) : 0;
+
+  table_.assign(count, EvalCacheEntry{});
+  table_.shrink_to_fit();
+  mask_ = count ? count - 1 : 0;
+}
@@ -20,20 +20,41 @@
 
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
-#include <array>
+#include <vector>
 
 #include "types.hpp"
 
-template<typename Entry, std::size_t N>
+/// A direct mapped table of entries owned by a single thread, the number of entries is a power of two
+template<typename Entry>
 struct Table
 {
+  /// resize() makes room for as many entries as fit in size_mb, keeping at least one so a lookup always has a slot
+  void resize(const std::size_t size_mb)
+  {
+    const auto entries = size_mb * 1024 * 1024 / sizeof(Entry);
+    const auto count   = std::max<std::size_t>(std::bit_floor(entries), 1);
+
+    table_.assign(count, Entry{});
+    table_.shrink_to_fit();
+    mask_ = count - 1;
+  }
+
   [[nodiscard]]
   Entry *operator[](const Key key) noexcept
   {
-    return &table_[static_cast<std::uint32_t>(key) & (N - 1)];
+    return &table_[static_cast<std::uint32_t>(key) & mask_];
+  }
+
+  [[nodiscard]]
+  std::size_t bytes() const noexcept
+  {
+    return table_.size() * sizeof(Entry);
   }
 
 private:
-  std::array<Entry, N> table_{};
+  std::vector<Entry> table_{1};
+  std::size_t mask_{};
 };
@@ -41,14 +41,27 @@ typedef bool (*fun3_t)(HANDLE, CONST GROUP_AFFINITY *, PGROUP_AFFINITY);
 }
 #endif
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif
+
+#include <array>
 #include <vector>
 #include <optional>
+#include <fstream>
+#include <cstdlib>
 #include <sstream>
 #include <cstdint>
 
 #include <fmt/format.h>
 
 #include "miscellaneous.hpp"
+#include "numa.hpp"
 #include "util.hpp"
 
 namespace
@@ -67,6 +80,96 @@ std::string compiler_info()
 #endif
 }
 
+#if defined(__linux__)
+
+constexpr std::size_t SmallPageSize = 4 * 1024;
+constexpr std::size_t HugePageSize  = 2 * 1024 * 1024;
+constexpr std::size_t GigaPageSize  = 1024 * 1024 * 1024;
+
+constexpr std::size_t round_up(const std::size_t size, const std::size_t alignment)
+{
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+std::optional<memory::LargeBlock> map_explicit(const std::size_t size, const std::size_t page_size, const int flags)
+{
+  const auto len = round_up(size, page_size);
+  auto *mem      = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | flags, -1, 0);
+
+  if (mem == MAP_FAILED)
+    return std::nullopt;
+
+  return memory::LargeBlock{.mem = mem, .ptr = mem, .size = len, .page_size = page_size, .mapped = true};
+}
+
+bool transparent_huge_pages_enabled()
+{
+  std::ifstream f("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string mode;
+  std::getline(f, mode);
+  return f && mode.find("[never]") == std::string::npos;
+}
+
+std::optional<memory::LargeBlock> map_transparent(const std::size_t size)
+{
+  // Over-reserve so the block can be aligned to a huge page boundary, the
+  // kernel only backs aligned 2MB ranges with transparent huge pages
+  const auto len     = round_up(size, HugePageSize);
+  const auto reserve = len + HugePageSize;
+  auto *mem          = mmap(nullptr, reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (mem == MAP_FAILED)
+    return std::nullopt;
+
+  const auto base    = reinterpret_cast<std::uintptr_t>(mem);
+  const auto aligned = round_up(base, HugePageSize);
+
+  if (const auto head = aligned - base; head > 0)
+    munmap(mem, head);
+
+  if (const auto tail = base + reserve - (aligned + len); tail > 0)
+    munmap(reinterpret_cast<void *>(aligned + len), tail);
+
+  auto *ptr              = reinterpret_cast<void *>(aligned);
+  const auto transparent = transparent_huge_pages_enabled() && madvise(ptr, len, MADV_HUGEPAGE) == 0;
+
+  return memory::LargeBlock{.mem         = ptr,
+                            .ptr         = ptr,
+                            .size        = len,
+                            .page_size   = transparent ? HugePageSize : SmallPageSize,
+                            .mapped      = true,
+                            .transparent = transparent};
+}
+
+/// numa_interleave() spreads the pages of the block across all online NUMA
+/// nodes. It must be applied before the memory is touched for the first time.
+
+void numa_interleave(memory::LargeBlock &block)
+{
+  std::ifstream f("/sys/devices/system/node/online");
+  std::string online;
+  std::getline(f, online);
+
+  const auto nodes = numa::parse_cpu_list(online);
+
+  if (nodes.size() < 2)
+    return;
+
+  constexpr std::size_t MaxNodes = 1024;
+  constexpr std::size_t WordBits = sizeof(unsigned long) * 8;
+
+  std::array<unsigned long, MaxNodes / WordBits> mask{};
+
+  for (const auto node : nodes)
+    if (node < MaxNodes)
+      mask[node / WordBits] |= 1ul << (node % WordBits);
+
+  if (syscall(SYS_mbind, block.mem, block.size, MPOL_INTERLEAVE, mask.data(), MaxNodes + 1, 0) == 0)
+    block.nodes = nodes.size();
+}
+
+#endif
+
 }   // namespace
 
 namespace WinProcGroup
@@ -181,6 +284,118 @@ void bind_this_thread(const std::size_t idx)
 
 }   // namespace WinProcGroup
 
+namespace memory
+{
+
+namespace
+{
+
+constexpr std::size_t MB = 1024 * 1024;
+constexpr std::size_t GB = 1024 * MB;
+
+}   // namespace
+
+LargeBlock alloc_large(const std::size_t size)
+{
+#if defined(__linux__)
+
+  auto block = [size] {
+#if defined(MAP_HUGE_SHIFT)
+    // the page size is encoded as log2 in the mmap flags
+    if (size >= GigaPageSize)
+      if (auto b = map_explicit(size, GigaPageSize, 30 << MAP_HUGE_SHIFT); b)
+        return b;
+
+    if (auto b = map_explicit(size, HugePageSize, 21 << MAP_HUGE_SHIFT); b)
+      return b;
+#endif
+    return map_transparent(size);
+  }();
+
+  if (block)
+  {
+    numa_interleave(*block);
+    return *block;
+  }
+
+#endif
+
+  // Fallback, plain heap memory aligned to the cache line size by hand
+  auto *mem = std::malloc(size + CacheLineSize - 1);
+
+  if (!mem)
+    return {};
+
+  auto *ptr = reinterpret_cast<void *>((reinterpret_cast<std::uintptr_t>(mem) + CacheLineSize - 1) & ~static_cast<std::uintptr_t>(CacheLineSize - 1));
+
+  return LargeBlock{.mem = mem, .ptr = ptr, .size = size + CacheLineSize - 1};
+}
+
+void free_large(LargeBlock &block)
+{
+#if defined(__linux__)
+  if (block.mapped)
+    munmap(block.mem, block.size);
+  else
+#endif
+    std::free(block.mem);
+
+  block = {};
+}
+
+LargeBlock map_file([[maybe_unused]] const std::string &path, [[maybe_unused]] const std::size_t size)
+{
+#if defined(__linux__)
+
+  const auto fd = open(path.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    return {};
+
+  struct stat st{};
+  auto *mem = MAP_FAILED;
+
+  if (fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= size)
+    mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+  // the mapping keeps its own reference to the file
+  close(fd);
+
+  if (mem == MAP_FAILED)
+    return {};
+
+  // start reading the file in the background, pages are otherwise loaded on first access
+  madvise(mem, size, MADV_WILLNEED);
+
+  return LargeBlock{.mem = mem, .ptr = mem, .size = size, .page_size = SmallPageSize, .mapped = true};
+
+#else
+
+  return {};
+
+#endif
+}
+
+std::string page_size_name(const LargeBlock &block)
+{
+  const auto page_size = block.page_size;
+
+  if (page_size == 0)
+    return "default";
+
+  const auto kind = block.transparent ? " transparent" : "";
+
+  if (page_size >= GB)
+    return fmt::format("{}GB{}", page_size / GB, kind);
+
+  if (page_size >= MB)
+    return fmt::format("{}MB{}", page_size / MB, kind);
+
+  return fmt::format("{}KB", page_size / 1024);
+}
+
+}   // namespace memory
+
 namespace misc
 {
 
@@ -217,7 +432,13 @@ std::string print_engine_info()
 
 #if defined(NO_PREFETCH)
 
-  fmt::format_to(inserter, " - NO PREFETCH")
+  fmt::format_to(inserter, " - NO PREFETCH");
+
+#endif
+
+#if defined(TT_STATS)
+
+  fmt::format_to(inserter, " - TT STATS");
 
 #endif
 
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <string_view>
 #include <string>
 
@@ -74,6 +75,42 @@ namespace WinProcGroup
 void bind_this_thread(std::size_t idx);
 }
 
+/// Large memory blocks, like the transposition table, are backed by huge
+/// pages when the platform provides them. On Linux explicit huge pages
+/// (1GB, then 2MB) are attempted first, otherwise transparent huge pages are
+/// requested with madvise(). On systems with more than one NUMA node the
+/// pages are interleaved across all nodes, so the parallel first-touch when
+/// clearing spreads the memory evenly.
+
+namespace memory
+{
+
+struct LargeBlock final
+{
+  void *mem{};              // address to release
+  void *ptr{};              // cache line aligned start of the usable memory
+  std::size_t size{};       // number of bytes reserved at mem
+  std::size_t page_size{};  // page size backing the block, 0 if unknown
+  std::size_t nodes{1};     // number of NUMA nodes the block is interleaved over
+  bool mapped{};
+  bool transparent{};       // huge pages are only advised, the kernel may not provide them
+};
+
+[[nodiscard]]
+LargeBlock alloc_large(std::size_t size);
+
+void free_large(LargeBlock &block);
+
+/// map_file() maps the first size bytes of a file copy-on-write, changes are
+/// never written back. The block is empty if the file could not be mapped.
+[[nodiscard]]
+LargeBlock map_file(const std::string &path, std::size_t size);
+
+[[nodiscard]]
+std::string page_size_name(const LargeBlock &block);
+
+}   // namespace memory
+
 namespace misc
 {
 template<bool AsUci>
@@ -31,7 +31,7 @@ template<Color Us>
 bool can_castle_short(Board *b)
 {
   constexpr auto cr = make_castling<Us, KING_SIDE>();
-  return b->can_castle(cr) && !b->is_castleling_impeeded(cr);
+  return b->can_castle(cr) && !b->is_castleling_impeeded(cr) && !b->is_king_path_attacked<KING_SIDE, Us>();
 }
 
 template<Color Us>
@@ -39,7 +39,7 @@ template<Color Us>
 bool can_castle_long(Board *b)
 {
   constexpr auto cr = make_castling<Us, QUEEN_SIDE>();
-  return b->can_castle(cr) && !b->is_castleling_impeeded(cr);
+  return b->can_castle(cr) && !b->is_castleling_impeeded(cr) && !b->is_king_path_attacked<QUEEN_SIDE, Us>();
 }
 
 }   // namespace
@@ -61,8 +61,10 @@ MoveData *add_move(
     return NO_PIECE;
   };
 
+  // the moves are encoded as by the search generator, a black piece of no type is not NO_PIECE
   const auto captured_piece = captured();
-  const auto move           = init_move(pc, captured_piece, from, to, mt, make_piece(promo_pt, Us));
+  const auto promoted       = promo_pt == NO_PT ? NO_PIECE : make_piece(promo_pt, Us);
+  const auto move           = init_move(pc, captured_piece, from, to, mt, promoted);
 
   // if constexpr (Flags & LEGALMOVES)
   if (!b->is_legal(move, pc, from, mt))
@@ -23,6 +23,7 @@
 #include "moves.hpp"
 #include "board.hpp"
 #include "bitboard.hpp"
+#include "tpool.hpp"
 
 namespace
 {
@@ -73,7 +74,7 @@ void score_move(MoveData &md, Board *b)
     else if (b->pos->last_move && b->counter_move(b->pos->last_move) == md)
       md.score = 60000;
     else
-      md.score = b->history_score(md);
+      md.score = b->history_score(md) + b->my_thread()->ordering_noise(md);
   } else
   {
     if (is_queen_promotion(md))
@@ -487,7 +488,7 @@ template<Color Us>
 bool Moves<Tuning>::can_castle_short() const
 {
   constexpr auto cr = make_castling<Us, KING_SIDE>();
-  return b->can_castle(cr) && !b->is_castleling_impeeded(cr);
+  return b->can_castle(cr) && !b->is_castleling_impeeded(cr) && !b->is_king_path_attacked<KING_SIDE, Us>();
 }
 
 template<bool Tuning>
@@ -495,5 +496,5 @@ template<Color Us>
 bool Moves<Tuning>::can_castle_long() const
 {
   constexpr auto cr = make_castling<Us, QUEEN_SIDE>();
-  return b->can_castle(cr) && !b->is_castleling_impeeded(cr);
+  return b->can_castle(cr) && !b->is_castleling_impeeded(cr) && !b->is_king_path_attacked<QUEEN_SIDE, Us>();
 }
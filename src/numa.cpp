@@ -0,0 +1,340 @@
+/*
+  Feliscatus, a UCI chess playing engine derived from Tomcat 1.0 (Bobcat 8.0)
+  Copyright (C) 2008-2016 Gunnar Harms (Bobcat author)
+  Copyright (C) 2017      FireFather (Tomcat author)
+  Copyright (C) 2020-2022 Rudy Alex Kohn
+
+  Feliscatus is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Feliscatus is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include "numa.hpp"
+#include "miscellaneous.hpp"
+#include "util.hpp"
+
+namespace
+{
+
+// the number of "auto" cpus handed out to the pools of the process so far
+std::atomic_size_t auto_cpus_taken{};
+
+// cpus from this number on can not be bound, it is the size of cpu_set_t on Linux
+#if defined(__linux__)
+constexpr std::size_t MaxCpus = CPU_SETSIZE;
+#else
+constexpr std::size_t MaxCpus = 1024;
+#endif
+
+#if defined(__linux__)
+
+constexpr std::size_t MaxNodes = 1024;
+constexpr std::size_t WordBits = sizeof(unsigned long) * 8;
+
+using NodeMask = std::array<unsigned long, MaxNodes / WordBits>;
+
+std::string read_line(const std::string &path)
+{
+  std::ifstream f(path);
+  std::string line;
+  std::getline(f, line);
+  return line;
+}
+
+struct NodeCpus final
+{
+  int node;
+  std::vector<std::size_t> cores;
+  std::vector<std::size_t> siblings;
+};
+
+/// cpus_by_node() returns the cpus of each online node the process is allowed
+/// to run on, split into physical cores and their SMT siblings
+
+std::vector<NodeCpus> cpus_by_node()
+{
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  sched_getaffinity(0, sizeof allowed, &allowed);
+
+  auto nodes           = numa::parse_cpu_list(read_line("/sys/devices/system/node/online"));
+  const auto has_nodes = !nodes.empty();
+
+  if (!has_nodes)
+    nodes.emplace_back(0);
+
+  std::vector<NodeCpus> result;
+
+  for (const auto n : nodes)
+  {
+    const auto cpus = numa::parse_cpu_list(read_line(
+      has_nodes ? fmt::format("/sys/devices/system/node/node{}/cpulist", n) : "/sys/devices/system/cpu/online"));
+
+    auto &[node, cores, siblings] = result.emplace_back(static_cast<int>(n));
+
+    for (const auto cpu : cpus)
+    {
+      if (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed))
+        continue;
+
+      const auto thread_siblings =
+        numa::parse_cpu_list(read_line(fmt::format("/sys/devices/system/cpu/cpu{}/topology/thread_siblings_list", cpu)));
+
+      if (thread_siblings.empty() || thread_siblings.front() == cpu)
+        cores.emplace_back(cpu);
+      else
+        siblings.emplace_back(cpu);
+    }
+  }
+
+  return result;
+}
+
+/// auto_placements() fills one node at a time with threads on physical cores,
+/// remaining threads are put on SMT siblings spread evenly across the nodes
+
+std::vector<numa::BoundCpu> auto_placements()
+{
+  const auto nodes = cpus_by_node();
+
+  // binding only pays off when memory access is non-uniform
+  if (nodes.size() < 2)
+    return {};
+
+  std::vector<numa::BoundCpu> result;
+
+  for (const auto &[node, cores, siblings] : nodes)
+    for (const auto cpu : cores)
+      result.emplace_back(cpu, node);
+
+  const auto max_siblings = std::max_element(nodes.begin(), nodes.end(), [](const NodeCpus &a, const NodeCpus &b) {
+                              return a.siblings.size() < b.siblings.size();
+                            })->siblings.size();
+
+  for (std::size_t i = 0; i < max_siblings; ++i)
+    for (const auto &[node, cores, siblings] : nodes)
+      if (i < siblings.size())
+        result.emplace_back(siblings[i], node);
+
+  return result;
+}
+
+int node_of_cpu(const std::size_t cpu)
+{
+  for (const auto n : numa::parse_cpu_list(read_line("/sys/devices/system/node/online")))
+  {
+    const auto cpus = numa::parse_cpu_list(read_line(fmt::format("/sys/devices/system/node/node{}/cpulist", n)));
+
+    if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end())
+      return static_cast<int>(n);
+  }
+
+  return 0;
+}
+
+bool set_preferred_node(const int node)
+{
+  if (node < 0 || static_cast<std::size_t>(node) >= MaxNodes)
+    return false;
+
+  NodeMask mask{};
+  mask[node / WordBits] |= 1ul << (node % WordBits);
+
+  return syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), MaxNodes + 1) == 0;
+}
+
+#endif
+
+}   // namespace
+
+namespace numa
+{
+
+std::vector<std::size_t> parse_cpu_list(std::string_view list)
+{
+  std::vector<std::size_t> result;
+
+  // more digits than any cpu number has would overflow
+  const auto is_number = [](const std::string_view s) {
+    return !s.empty() && s.size() < 10
+        && std::all_of(s.begin(), s.end(), [](const char c) { return std::isdigit(static_cast<unsigned char>(c)); });
+  };
+
+  const auto is_space = [](const char c) {
+    return std::isspace(static_cast<unsigned char>(c));
+  };
+
+  while (!list.empty())
+  {
+    const auto comma = list.find(',');
+    auto range       = list.substr(0, comma);
+    list             = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+    while (!range.empty() && is_space(range.front()))
+      range.remove_prefix(1);
+
+    while (!range.empty() && is_space(range.back()))
+      range.remove_suffix(1);
+
+    const auto dash        = range.find('-');
+    const auto first_range = range.substr(0, dash);
+    const auto last_range  = dash == std::string_view::npos ? first_range : range.substr(dash + 1);
+
+    if (!is_number(first_range) || !is_number(last_range))
+      return {};
+
+    const auto first = util::to_integral<std::size_t>(first_range);
+    const auto last  = util::to_integral<std::size_t>(last_range);
+
+    if (first > last)
+      return {};
+
+    // a range can not list more cpus than can be bound
+    for (auto cpu = first; cpu <= std::min(last, MaxCpus - 1); ++cpu)
+      result.emplace_back(cpu);
+  }
+
+  return result;
+}
+
+bool Placement::configure(const std::string_view binding, const std::size_t thread_count)
+{
+  if (binding == binding_ && thread_count == thread_count_)
+    return false;
+
+  const auto old_cpus         = std::exchange(cpus_, {});
+  const auto old_thread_count = std::exchange(thread_count_, thread_count);
+
+  binding_ = binding;
+
+#if defined(__linux__)
+
+  if (binding == "auto")
+  {
+    const auto cpus = auto_placements();
+
+    // the pools of the process share the cpus, this one keeps the first cpu it was given
+    if (!cpus.empty() && !first_auto_)
+      first_auto_ = auto_cpus_taken.fetch_add(thread_count);
+
+    for (std::size_t i = 0; i < std::min(thread_count, cpus.size()); ++i)
+      cpus_.emplace_back(cpus[(*first_auto_ + i) % cpus.size()]);
+  } else if (!binding.empty() && binding != "off")
+  {
+    if (const auto cpus = parse_cpu_list(binding); !cpus.empty())
+    {
+      for (std::size_t i = 0; i < thread_count; ++i)
+        cpus_.emplace_back(cpus[i % cpus.size()], node_of_cpu(cpus[i % cpus.size()]));
+    } else
+      fmt::print("info string Thread Binding '{}' is not a valid cpu list, threads are not bound\n", binding);
+  }
+
+  if (!cpus_.empty())
+  {
+    auto nodes = std::vector<int>(cpus_.size());
+    std::transform(cpus_.begin(), cpus_.end(), nodes.begin(), [](const BoundCpu &c) { return c.node; });
+    std::sort(nodes.begin(), nodes.end());
+
+    const auto node_count = std::distance(nodes.begin(), std::unique(nodes.begin(), nodes.end()));
+
+    fmt::print("info string Thread Binding {} threads pinned over {} NUMA nodes\n", cpus_.size(), node_count);
+  }
+
+#else
+
+  // Windows processor groups are only needed when using more than 64 threads,
+  // keep the previous threshold of binding from 8 threads
+  const auto old_group_threads = std::exchange(group_threads_, thread_count > 8 ? thread_count : 0);
+
+  if ((old_group_threads > 0) != (group_threads_ > 0) && old_thread_count > 0)
+    return true;
+
+#endif
+
+  // the threads the pool keeps only pin themselves when they start
+  const auto bound = [](const std::vector<BoundCpu> &cpus, const std::size_t idx) {
+    return idx < cpus.size() ? std::make_optional(cpus[idx]) : std::nullopt;
+  };
+
+  for (std::size_t i = 0; i < std::min(old_thread_count, thread_count); ++i)
+    if (bound(old_cpus, i) != bound(cpus_, i))
+      return true;
+
+  return false;
+}
+
+void Placement::bind_this_thread(const std::size_t idx) const
+{
+#if defined(__linux__)
+
+  if (idx >= cpus_.size())
+    return;
+
+  const auto [cpu, node] = cpus_[idx];
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  pthread_setaffinity_np(pthread_self(), sizeof set, &set);
+
+  // memory allocated by the thread from now on should be local to it
+  set_preferred_node(node);
+
+#else
+
+  if (idx < group_threads_)
+    WinProcGroup::bind_this_thread(idx);
+
+#endif
+}
+
+int Placement::node(const std::size_t idx) const
+{
+  return idx < cpus_.size() ? cpus_[idx].node : -1;
+}
+
+PreferredNode::PreferredNode([[maybe_unused]] const int node)
+{
+#if defined(__linux__)
+  active_ = set_preferred_node(node);
+#endif
+}
+
+PreferredNode::~PreferredNode()
+{
+#if defined(__linux__)
+  if (active_)
+    syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+#endif
+}
+
+}   // namespace numa
@@ -0,0 +1,96 @@
+/*
+  Feliscatus, a UCI chess playing engine derived from Tomcat 1.0 (Bobcat 8.0)
+  Copyright (C) 2008-2016 Gunnar Harms (Bobcat author)
+  Copyright (C) 2017      FireFather (Tomcat author)
+  Copyright (C) 2020-2022 Rudy Alex Kohn
+
+  Feliscatus is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Feliscatus is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Thread placement for the search threads.
+///
+/// The "Thread Binding" option controls how threads are pinned:
+///  - "off"  : the OS decides where threads run
+///  - "auto" : on machines with more than one NUMA node, threads are pinned
+///             to physical cores one node at a time, SMT siblings are used
+///             last and spread across the nodes. Each engine in the process
+///             starts its threads after the cpus of the engines before it.
+///  - a cpu list like "0-7,16-23" : thread n is pinned to the n'th listed cpu
+///
+/// Each pinned thread prefers memory from its own node, and the pool uses
+/// PreferredNode while creating a thread so its data is placed there as well.
+
+namespace numa
+{
+
+/// parse_cpu_list() parses a list in the format used by the kernel, i.e. "0-3,8,10-11"
+[[nodiscard]]
+std::vector<std::size_t> parse_cpu_list(std::string_view list);
+
+/// The cpu a thread is pinned to and the NUMA node of that cpu
+struct BoundCpu final
+{
+  std::size_t cpu;
+  int node;
+
+  bool operator==(const BoundCpu &other) const = default;
+};
+
+/// The cpus the threads of one pool are pinned to
+struct Placement final
+{
+  /// configure() computes the placement for thread_count threads, if the binding or the thread count differs from
+  /// the last call. Returns true if a thread below both counts moved. Must be called while no thread of the pool runs.
+  bool configure(std::string_view binding, std::size_t thread_count);
+
+  /// bind_this_thread() pins the calling thread according to the placement of thread idx
+  void bind_this_thread(std::size_t idx) const;
+
+  /// node() returns the NUMA node of thread idx, or -1 if the thread is not bound
+  [[nodiscard]]
+  int node(std::size_t idx) const;
+
+private:
+  std::string binding_{"off"};
+  std::size_t thread_count_{};
+  std::vector<BoundCpu> cpus_{};
+  std::optional<std::size_t> first_auto_{};   // the first of the "auto" cpus used by this pool
+#if !defined(__linux__)
+  std::size_t group_threads_{};
+#endif
+};
+
+/// Makes allocations by the calling thread prefer the given node for the lifetime of the object
+struct PreferredNode final
+{
+  explicit PreferredNode(int node);
+  ~PreferredNode();
+  PreferredNode(const PreferredNode &other) = delete;
+  PreferredNode(PreferredNode &&other)      = delete;
+  PreferredNode &operator=(const PreferredNode &) = delete;
+  PreferredNode &operator=(PreferredNode &&other) = delete;
+
+private:
+  bool active_{};
+};
+
+}   // namespace numa
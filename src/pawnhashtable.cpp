@@ -81,7 +81,8 @@ PawnHashEntry *at<false>(const Board *b)
   const auto pawn_key = b->pawn_key();
   auto *entry = b->my_thread()->pawn_hash[pawn_key];
 
-  if (entry->zkey == 0)
+  // a position without pawns and white to move has a zero key, which also matches an unused slot
+  if (entry->zkey != pawn_key || !pawn_key)
   {
     entry->scores[WHITE] = eval_pawns<WHITE>(b, entry);
     entry->scores[BLACK] = eval_pawns<BLACK>(b, entry);
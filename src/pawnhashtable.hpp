@@ -49,7 +49,7 @@ struct alignas(CacheLineSize / 2) PawnHashEntry final
 };
 #pragma pack()
 
-using PawnHashTable = Table<PawnHashEntry, 131072>;
+using PawnHashTable = Table<PawnHashEntry>;
 
 namespace Pawn
 {
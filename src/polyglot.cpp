@@ -280,7 +280,7 @@ auto PolyBook::select_random(BookIterator first, BookIterator second) const
 ///
 /// O(log(n)) lookup of known entries by key
 ///
-Move PolyBook::probe(Board *board) const
+Move PolyBook::probe(Board *board, const bool best_move) const
 {
   const auto key = poly_key(board);
 
@@ -295,7 +295,7 @@ Move PolyBook::probe(Board *board) const
 
   // In case we have set best book move,
   // we don't have to look any further
-  if (Options[uci::uci_name<uci::UciOptions::BOOK_BEST_MOVE>()])
+  if (best_move)
     e = &(*lower_boundry);
   else
   {
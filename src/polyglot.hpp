@@ -33,7 +33,8 @@ struct PolyBook
 
   void open(std::string_view path);
 
-  Move probe(Board *board) const;
+  /// probe() returns a move from the book, the one with the highest weight if best_move is set
+  Move probe(Board *board, bool best_move) const;
 
   std::size_t size() const;
 
@@ -29,7 +29,7 @@ void Position::clear()
   key                = 0;
   last_move          = MOVE_NONE;
   null_moves_in_row  = 0;
-  transposition      = nullptr;
+  transp_found       = false;
   last_move          = MOVE_NONE;
   checkers           = ZeroBB;
   in_check           = false;
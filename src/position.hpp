@@ -22,8 +22,6 @@
 
 #include "material.hpp"
 
-struct HashEntry;
-
 using KillerMoves = std::array<Move, 4>;
 
 struct Position final
@@ -43,7 +41,7 @@ struct Position final
   NodeType transp_type{};
   Move transp_move{};
   int flags{};
-  HashEntry *transposition{};
+  bool transp_found{};
   KillerMoves killer_moves{};
   Bitboard checkers{};
   bool in_check{};
@@ -20,6 +20,9 @@
 
 #pragma once
 
+#include <array>
+#include <span>
+
 #include "types.hpp"
 
 struct PVEntry final
@@ -32,3 +35,41 @@ struct PVEntry final
   NodeType node_type;
   int eval;
 };
+
+/// Triangular table of principal variations. The line of a ply only holds the moves from that ply and on,
+/// so it needs about half the entries of a square MAXDEPTH x MAXDEPTH table.
+/// pv[ply][i] is valid for ply <= i < MAXDEPTH, lower indices belong to the line of the previous ply.
+struct PVTable final
+{
+  [[nodiscard]]
+  std::span<PVEntry, MAXDEPTH> operator[](const std::size_t ply) noexcept
+  {
+    return std::span<PVEntry, MAXDEPTH>{entries_.data() + line_offset(ply) - ply, MAXDEPTH};
+  }
+
+  [[nodiscard]]
+  std::span<const PVEntry, MAXDEPTH> operator[](const std::size_t ply) const noexcept
+  {
+    return std::span<const PVEntry, MAXDEPTH>{entries_.data() + line_offset(ply) - ply, MAXDEPTH};
+  }
+
+  [[nodiscard]]
+  std::span<PVEntry, MAXDEPTH> front() noexcept
+  {
+    return (*this)[0];
+  }
+
+  void clear() noexcept
+  {
+    entries_.fill({});
+  }
+
+private:
+  [[nodiscard]]
+  static constexpr std::size_t line_offset(const std::size_t ply) noexcept
+  {
+    return ply * MAXDEPTH - ply * (ply - 1) / 2;
+  }
+
+  std::array<PVEntry, MAXDEPTH * (MAXDEPTH + 1) / 2> entries_{};
+};
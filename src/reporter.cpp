@@ -0,0 +1,180 @@
+/*
+  Feliscatus, a UCI chess playing engine derived from Tomcat 1.0 (Bobcat 8.0)
+  Copyright (C) 2008-2016 Gunnar Harms (Bobcat author)
+  Copyright (C) 2017      FireFather (Tomcat author)
+  Copyright (C) 2020-2022 Rudy Alex Kohn
+
+  Feliscatus is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Feliscatus is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+#include "reporter.hpp"
+#include "tpool.hpp"
+#include "uci.hpp"
+
+Reporter::Reporter(const thread_pool &pool) : pool_(pool)
+{ }
+
+Reporter::~Reporter()
+{
+  if (!worker_.joinable())
+    return;
+
+  flush();
+
+  // the reporter thread waits for the tail to move, an empty slot wakes it up to see the exit flag
+  exit_.store(true);
+  tail_.fetch_add(1);
+  tail_.notify_one();
+}
+
+void Reporter::post_info(const int d, const int selective_depth) noexcept
+{
+  // the next info line has newer numbers anyway
+  auto *const report = slot(false);
+
+  [[unlikely]]
+  if (!report)
+    return;
+
+  report->kind            = Report::Kind::Info;
+  report->depth           = d;
+  report->selective_depth = selective_depth;
+  report->nodes           = pool_.node_count(*pool_.main());
+  report->elapsed         = pool_.main()->time.elapsed();
+  publish();
+}
+
+void Reporter::post_curr_move(const Move m, const int m_number) noexcept
+{
+  auto *const report = slot(false);
+
+  [[unlikely]]
+  if (!report)
+    return;
+
+  report->kind        = Report::Kind::CurrMove;
+  report->move        = m;
+  report->move_number = m_number;
+  publish();
+}
+
+void Reporter::post_pv(
+  const int d, const int max_ply, const int score, const std::span<const PVEntry> pv_line, const NodeType nt,
+  const int multi_pv) noexcept
+{
+  // a principal variation is never dropped, the GUI would miss the line or even the best move of the search
+  auto *const report = slot(true);
+
+  assert(pv_line.size() <= report->pv.size());
+
+  report->kind            = Report::Kind::Pv;
+  report->depth           = d;
+  report->selective_depth = max_ply;
+  report->score           = score;
+  report->node_type       = nt;
+  report->multi_pv        = multi_pv;
+  report->nodes           = pool_.node_count(*pool_.main());
+  report->elapsed         = pool_.main()->time.elapsed();
+  report->pv_length       = static_cast<int>(pv_line.size());
+  std::ranges::transform(pv_line, report->pv.begin(), &PVEntry::move);
+  publish();
+}
+
+void Reporter::flush()
+{
+  const auto tail = tail_.load(std::memory_order_relaxed);
+
+  for (auto head = head_.load(std::memory_order_acquire); head != tail; head = head_.load(std::memory_order_acquire))
+    head_.wait(head, std::memory_order_acquire);
+}
+
+Report *Reporter::slot(const bool wait) noexcept
+{
+  [[unlikely]]
+  if (!worker_.joinable())
+    worker_ = std::jthread(&Reporter::run, this);
+
+  const auto tail = tail_.load(std::memory_order_relaxed);
+  auto head       = head_.load(std::memory_order_acquire);
+
+  while (tail - head == capacity)
+  {
+    [[unlikely]]
+    if (!wait)
+      return nullptr;
+
+    head_.wait(head, std::memory_order_acquire);
+    head = head_.load(std::memory_order_acquire);
+  }
+
+  return &ring_[tail % capacity];
+}
+
+void Reporter::publish() noexcept
+{
+  tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  tail_.notify_one();
+}
+
+void Reporter::run()
+{
+  fmt::memory_buffer buffer;
+  auto head = head_.load(std::memory_order_relaxed);
+
+  while (true)
+  {
+    tail_.wait(head, std::memory_order_acquire);
+
+    [[unlikely]]
+    if (exit_.load())
+      break;
+
+    const auto tail = tail_.load(std::memory_order_acquire);
+
+    for (; head != tail; ++head)
+      format(ring_[head % capacity], buffer);
+
+    std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+    std::fflush(stdout);
+    buffer.clear();
+
+    // the slots can only be reused once they have been formatted
+    head_.store(head, std::memory_order_release);
+    head_.notify_all();
+  }
+}
+
+void Reporter::format(const Report &report, fmt::memory_buffer &buffer) const
+{
+  switch (report.kind)
+  {
+  case Report::Kind::Info:
+    uci::format_info(buffer, pool_, report.nodes, report.elapsed, report.depth, report.selective_depth);
+    break;
+
+  case Report::Kind::CurrMove:
+    uci::format_curr_move(buffer, report.move, report.move_number);
+    break;
+
+  case Report::Kind::Pv:
+    uci::format_pv(
+      buffer, pool_, report.nodes, report.elapsed, report.depth, report.selective_depth, report.score,
+      std::span{report.pv}.first(static_cast<std::size_t>(report.pv_length)), report.node_type, report.multi_pv);
+    break;
+  }
+}
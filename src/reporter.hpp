@@ -0,0 +1,113 @@
+/*
+  Feliscatus, a UCI chess playing engine derived from Tomcat 1.0 (Bobcat 8.0)
+  Copyright (C) 2008-2016 Gunnar Harms (Bobcat author)
+  Copyright (C) 2017      FireFather (Tomcat author)
+  Copyright (C) 2020-2022 Rudy Alex Kohn
+
+  Feliscatus is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Feliscatus is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <thread>
+
+#include <fmt/format.h>
+
+#include "engine_config.hpp"
+#include "miscellaneous.hpp"
+#include "pv_entry.hpp"
+#include "types.hpp"
+
+struct thread_pool;
+
+/// One line of search output, a snapshot of the search at the time it was posted
+struct Report final
+{
+  enum class Kind : std::uint8_t
+  {
+    Info,
+    CurrMove,
+    Pv
+  };
+
+  Kind kind{};
+  NodeType node_type{};
+  int depth{};
+  int selective_depth{};
+  int score{};
+  int move_number{};
+  int multi_pv{};
+  std::uint64_t nodes{};
+  TimeUnit elapsed{};
+  Move move{};
+  int pv_length{};
+  std::array<Move, MAXDEPTH> pv{};
+};
+
+/// Writes the output of the main search thread from a thread of its own.
+/// The main search thread hands over snapshots through a single producer, single consumer ring. The node count and
+/// the elapsed time are taken when a line is posted, with the exact count of the main thread, while the hash usage
+/// is added when the lines are formatted, and all pending lines are written at once. The ring holds the lines of two
+/// iterations at the largest MultiPV, so the search only waits when the output is stuck. When the ring is full an
+/// info or current move line is dropped, only a principal variation waits for a free slot. The thread is started by
+/// the first posted line, so an engine without output never starts it.
+struct Reporter final
+{
+  explicit Reporter(const thread_pool &pool);
+  ~Reporter();
+  Reporter(const Reporter &other) = delete;
+  Reporter(Reporter &&other)      = delete;
+  Reporter &operator=(const Reporter &) = delete;
+  Reporter &operator=(Reporter &&other) = delete;
+
+  void post_info(int d, int selective_depth) noexcept;
+
+  void post_curr_move(Move m, int m_number) noexcept;
+
+  /// post_pv() posts a principal variation, multi_pv is its rank when several lines are searched and 0 otherwise
+  void post_pv(int d, int max_ply, int score, std::span<const PVEntry> pv_line, NodeType nt, int multi_pv) noexcept;
+
+  /// flush() waits until every posted line has been written
+  void flush();
+
+private:
+  static constexpr std::uint32_t capacity = 2 * MaxMultiPv;
+
+  // the positions wrap around with the 32 bit counters
+  static_assert(std::has_single_bit(capacity));
+
+  /// slot() returns the next free slot of the ring. If the ring is full it waits for the reporter thread to write
+  /// out the pending lines when wait is true, and returns nullptr otherwise.
+  [[nodiscard]]
+  Report *slot(bool wait) noexcept;
+
+  /// publish() hands the slot returned by slot() to the reporter thread
+  void publish() noexcept;
+
+  void run();
+
+  void format(const Report &report, fmt::memory_buffer &buffer) const;
+
+  const thread_pool &pool_;
+  std::array<Report, capacity> ring_{};
+  alignas(CacheLineSize) std::atomic_uint32_t head_{};   // next slot to write out, only advanced by the reporter
+  alignas(CacheLineSize) std::atomic_uint32_t tail_{};   // next slot to fill, only advanced by the search
+  std::atomic_bool exit_{};
+  std::jthread worker_;
+};
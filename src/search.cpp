@@ -21,7 +21,11 @@
 #include <span>
 #include <cassert>
 #include <algorithm>
+#include <functional>
+#include <limits>
 #include <optional>
+#include <utility>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/rotating_file_sink.h>
@@ -62,11 +66,11 @@ constexpr int null_move_reduction(const int d)
   return 4 + d / 4;
 }
 
-void store_pv(const std::span<PVEntry> pv, const int pv_length)
+void store_pv(HashTable &tt, const std::span<PVEntry> pv, const int pv_length)
 {
   assert(pv_length > 0);
   std::for_each(pv.begin(), std::next(pv.begin(), pv_length), [&](const PVEntry &entry) {
-    TT.insert(entry);
+    tt.insert(entry);
   });
 }
 
@@ -77,27 +81,37 @@ constexpr int codec_t_table_score(const int score, const int ply)
 }
 
 [[nodiscard]]
-bool is_hash_score_valid(const Position *pos, const int depth, const int alpha, const int beta)
+bool is_hash_score_valid(const HashTable &tt, const Position *pos, const int depth, const int alpha, const int beta)
 {
-  return pos->transposition && pos->transposition->depth() >= depth
-         && (pos->transposition->is_exact() || (pos->transposition->is_beta() && pos->transp_score >= beta) || (pos->transposition->is_alpha() && pos->transp_score <= alpha));
+  const auto valid = pos->transp_found && pos->transp_depth >= depth
+                    && ((pos->transp_type & EXACT) || ((pos->transp_type & BETA) && pos->transp_score >= beta) || ((pos->transp_type & ALPHA) && pos->transp_score <= alpha));
+
+  if (valid)
+    tt.record_cutoff();
+
+  return valid;
 }
 
 void hash_and_evaluate(
-  Position *pos, Board *b, const std::size_t pool_index, const int alpha, const int beta, const int plies)
+  const HashTable &tt, Position *pos, Board *b, const std::size_t pool_index, const int alpha, const int beta,
+  const int plies)
 {
-  if ((pos->transposition = TT.find(b->key())) == nullptr)
+  const auto transposition = tt.find(b->key());
+
+  pos->transp_found = transposition.has_value();
+
+  if (!pos->transp_found)
   {
     pos->eval_score  = Eval::evaluate(b, pool_index, alpha, beta);
     pos->transp_type = NO_NT;
     pos->transp_move = MOVE_NONE;
   } else
   {
-    pos->transp_score = codec_t_table_score(pos->transposition->score(), -plies);
-    pos->eval_score   = codec_t_table_score(pos->transposition->eval(), -plies);
-    pos->transp_depth = pos->transposition->depth();
-    pos->transp_type  = pos->transposition->flags();
-    pos->transp_move  = pos->transposition->move();
+    pos->transp_score = codec_t_table_score(transposition->score(), -plies);
+    pos->eval_score   = codec_t_table_score(transposition->eval(), -plies);
+    pos->transp_depth = transposition->depth();
+    pos->transp_type  = transposition->flags();
+    pos->transp_move  = transposition->move();
     b->flags()        = 0;
   }
 }
@@ -141,12 +155,103 @@ void update_quiet_history(thread *t, Position *pos, const Move best_move, const
       k >>= 2;
 }
 
+/// best_thread() returns the thread whose root move is voted best by all threads,
+/// weighted by their score and completed depth
+
+[[nodiscard]]
+thread *best_thread(const thread_pool &pool)
+{
+  const auto has_move = [](const std::unique_ptr<thread> &t) {
+    return t->completed_depth > 0 && t->root_board->pos->pv_length > 0;
+  };
+
+  auto *best = pool.front().get();
+
+  if (pool.size() == 1)
+    return best;
+
+  const auto score = [](const thread *t) {
+    return t->pv[0][0].score;
+  };
+
+  auto min_score = MAXSCORE;
+
+  for (const auto &t : pool)
+    if (has_move(t))
+      min_score = std::min(min_score, score(t.get()));
+
+  // Each thread votes for its root move, deeper and better scoring threads weigh more
+  std::vector<std::pair<Move, std::int64_t>> votes;
+
+  const auto votes_for = [&votes](const Move m) -> std::int64_t & {
+    const auto it = std::ranges::find(votes, m, &std::pair<Move, std::int64_t>::first);
+    return it != votes.end() ? it->second : votes.emplace_back(m, 0).second;
+  };
+
+  for (const auto &t : pool)
+    if (has_move(t))
+      votes_for(t->pv[0][0].move) += static_cast<std::int64_t>(score(t.get()) - min_score + 14) * t->completed_depth;
+
+  // Start from the main thread, or from the first thread with a root move if it has none
+  if (!has_move(pool.front()))
+  {
+    if (const auto it = std::ranges::find_if(pool, has_move); it != pool.end())
+      best = it->get();
+  }
+
+  for (const auto &t : pool)
+  {
+    if (!has_move(t) || t.get() == best)
+      continue;
+
+    const auto best_score = score(best);
+    const auto t_score    = score(t.get());
+
+    // A proven mate is kept over any vote
+    if (best_score >= MAXSCORE - MAXDEPTH || t_score >= MAXSCORE - MAXDEPTH)
+    {
+      if (t_score > best_score)
+        best = t.get();
+    } else if (const auto t_votes = votes_for(t->pv[0][0].move), best_votes = votes_for(best->pv[0][0].move);
+               t_votes > best_votes || (t_votes == best_votes && t->completed_depth > best->completed_depth))
+      best = t.get();
+  }
+
+  return best;
+}
+
+// Depth skipping pattern for helper threads, indexed by (thread index - 1) % 20. A helper searches a depth only when
+// ((depth + phase) / size) is even, so groups of helpers work on different depths ahead of each other.
+constexpr std::array<int, 20> skip_size{1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr std::array<int, 20> skip_phase{0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+[[nodiscard]]
+bool skip_depth(const std::size_t thread_index, const int depth)
+{
+  const auto i = (thread_index - 1) % skip_size.size();
+  return ((depth + skip_phase[i]) / skip_size[i]) % 2 != 0;
+}
+
+/// A legal move at the root with the line found for it in the latest iteration that searched it
+struct RootMove final
+{
+  explicit RootMove(const Move m) : move(m)
+  { }
+
+  Move move;
+  int score{-MAXSCORE};
+  int previous_score{-MAXSCORE};   // the score of the iteration before, used for the window of its line
+  std::uint64_t nodes{};           // the size of its subtree in the current iteration
+  std::vector<PVEntry> pv{};
+};
+
 }   // namespace
 
 template<Searcher SearcherType>
 struct Search final
 {
-  explicit Search(Board *t_board) : b(t_board), t(t_board->my_thread())
+  explicit Search(Board *t_board)
+    : b(t_board), t(t_board->my_thread()), pool(t->pool), post_output(verbosity && pool.config.uci_output)
   { }
   ~Search()                   = default;
   Search()                    = delete;
@@ -155,19 +260,25 @@ struct Search final
   Search &operator=(const Search &) = delete;
   Search &operator=(Search &&other) = delete;
 
-  int go();
+  int go() noexcept;
 
 private:
+  int search_root(int depth, int alpha, int beta) noexcept;
+
+  template<NodeType NT, bool PV>
+  int search(int depth, int alpha, int beta) noexcept;
+
   template<NodeType NT, bool PV>
-  int search(int depth, int alpha, int beta);
+  std::optional<int>
+    search_move(Move m, Move singular, int depth, int move_count, int alpha, int beta, int &best_score) noexcept;
 
   template<NodeType NT, bool PV>
-  int search_next_depth(int depth, int alpha, int beta);
+  int search_next_depth(int depth, int alpha, int beta) noexcept;
 
   template<bool PV>
-  Move singular_move(int depth);
+  Move singular_move(int depth) noexcept;
 
-  auto search_fail_low(int depth, int alpha, Move exclude);
+  auto search_fail_low(int depth, int alpha, Move exclude) noexcept;
 
   [[nodiscard]]
   bool should_try_null_move(int beta) const;
@@ -182,18 +293,28 @@ private:
 
   template<bool PV>
   [[nodiscard]]
-  int search_quiesce(int alpha, int beta, int qs_ply);
+  int search_quiesce(int alpha, int beta, int qs_ply) noexcept;
 
-  bool make_move_and_evaluate(Move m, int alpha, int beta);
+  bool make_move_and_evaluate(Move m, int alpha, int beta) noexcept;
 
-  void unmake_move();
+  void unmake_move() noexcept;
 
-  void check_sometimes(std::uint64_t nodes) const;
+  void check_sometimes() const noexcept;
 
-  void check_time() const;
+  void check_time() const noexcept;
+
+  void check_node_limit() noexcept;
+
+  /// stopped() tells if the search has been stopped. Once it returns true every node returns at once without
+  /// using the scores of its children, so the scores on the way back to the root are meaningless.
+  [[nodiscard]]
+  bool stopped() const noexcept
+  {
+    return pool.stop.load(std::memory_order_relaxed);
+  }
 
   [[nodiscard]]
-  static bool is_analysing();
+  bool is_analysing() const;
 
   template<NodeType NT>
   void update_pv(Move m, int score, int depth) const;
@@ -211,14 +332,34 @@ private:
   [[nodiscard]]
   bool move_is_easy() const;
 
+  void init_root_moves();
+
+  void save_root_line();
+
+  void order_root_moves();
+
+  void restore_best_line();
+
+  void post_root_lines() const;
+
+  /// publish_root_lines() hands the ranked lines of a completed iteration to the main thread for the search result
+  void publish_root_lines() const;
+
+  static constexpr bool verbosity = SearcherType == Searcher::Master;
+
   Board *b;
   Position *pos{};
   thread *t;
-  static constexpr bool verbosity = SearcherType == Searcher::Master;
+  thread_pool &pool;
+  const bool post_output;   // the main thread of an instance that reports to a UCI GUI
+  std::vector<RootMove> root_moves{};   // the moves searched at the root, in the order they are searched
+  std::size_t lines{1};      // the number of best root moves searched with their own line, the MultiPV option
+  std::size_t pv_index{};    // the line being searched, the root moves before it already have their line
+  std::uint64_t node_check{std::numeric_limits<std::uint64_t>::max()};   // the node count to check the limit at
 };
 
 template<Searcher SearcherType>
-int Search<SearcherType>::go()
+int Search<SearcherType>::go() noexcept
 {
   init_search();
 
@@ -229,15 +370,36 @@ int Search<SearcherType>::go()
   {
     b->search_depth++;
 
-    try
+    if constexpr (SearcherType == Searcher::Slave)
+    {
+      if (pool.config.skip_depths && skip_depth(t->index(), b->search_depth))
+        continue;
+    }
+
+    for (auto &root_move : root_moves)
+    {
+      root_move.previous_score = std::exchange(root_move.score, -MAXSCORE);
+      root_move.nodes          = 0;
+    }
+
+    for (pv_index = 0; pv_index < lines; ++pv_index)
     {
+      // the first line keeps the window of the iteration before, the others start around their own last score
+      if (pv_index > 0)
+      {
+        const auto previous_score = root_moves[pv_index].previous_score;
+        const auto searched       = previous_score != -MAXSCORE;
+        alpha                     = searched ? std::max<int>(-MAXSCORE, previous_score - 20) : -MAXSCORE;
+        beta                      = searched ? std::min<int>(MAXSCORE, previous_score + 20) : MAXSCORE;
+      }
+
       do
       {
         t->pv_length[0] = 0;
 
-        hash_and_evaluate(pos, b, t->index(), alpha, beta, b->plies);
+        hash_and_evaluate(pool.tt, pos, b, t->index(), alpha, beta, b->plies);
 
-        const auto score = search<EXACT, true>(b->search_depth, alpha, beta);
+        const auto score = search_root(b->search_depth, alpha, beta);
 
         if (score > alpha && score < beta)
           break;
@@ -246,36 +408,148 @@ int Search<SearcherType>::go()
 
         alpha = std::max<int>(-MAXSCORE, score - 100);
         beta  = std::min<int>(MAXSCORE, score + 100);
-      } while (true);
+      } while (!stopped());
 
-      store_pv(t->pv.front(), t->pv_length.front());
+      // every node has taken back its own moves on the way out
+      assert(b->plies == 0);
 
       [[unlikely]]
-      if (move_is_easy())
+      if (stopped())
         break;
 
-      alpha = std::max<int>(-MAXSCORE, t->pv[0][0].score - 20);
-      beta  = std::min<int>(MAXSCORE, t->pv[0][0].score + 20);
-    } catch (const int)
+      store_pv(pool.tt, t->pv.front(), t->pv_length.front());
+      save_root_line();
+    }
+
+    [[unlikely]]
+    if (stopped())
     {
-      while (b->plies)
-        unmake_move();
+      // the iteration is not complete, but the moves found so far are kept in the table
+      if (pv_index > 0)
+        restore_best_line();
+      else if (const auto pv_len = t->pv_length.front(); pv_len)
+        store_pv(pool.tt, t->pv.front(), pv_len);
+      break;
+    }
 
-      [[likely]]
-      if (const auto pv_len = t->pv_length.front(); pv_len)
-        store_pv(t->pv.front(), pv_len);
+    order_root_moves();
+
+    if (lines > 1)
+    {
+      restore_best_line();
+
+      if (post_output)
+        post_root_lines();
     }
+
+    if constexpr (SearcherType == Searcher::Master)
+      publish_root_lines();
+
+    // read by the node limit check of the other threads
+    std::atomic_ref(t->completed_depth).store(b->search_depth, std::memory_order_relaxed);
+
+    [[unlikely]]
+    if (move_is_easy())
+      break;
+
+    alpha = std::max<int>(-MAXSCORE, t->pv[0][0].score - 20);
+    beta  = std::min<int>(MAXSCORE, t->pv[0][0].score + 20);
   }
+
+  t->publish_nodes();
+
   return 0;
 }
 
+template<Searcher SearcherType>
+int Search<SearcherType>::search_root(const int depth, int alpha, const int beta) noexcept
+{
+  const auto singular = singular_move<true>(depth);
+
+  auto best_move  = MOVE_NONE;
+  auto best_score = -MAXSCORE;
+  auto move_count = 0;
+
+  // the moves of the lines already searched in this iteration are left out
+  for (auto &root_move : std::span{root_moves}.subspan(pv_index))
+  {
+    const auto nodes = t->nodes;
+
+    [[unlikely]]
+    if (!make_move_and_evaluate(root_move.move, alpha, beta))
+      continue;
+
+    ++move_count;
+
+    if (post_output)
+    {
+      if (b->search_depth >= 20 && (pool.main()->timer.should_post_curr_move() || is_analysing()))
+        pool.reporter.post_curr_move(root_move.move, move_count);
+
+      if (pool.main()->timer.should_post_info())
+        pool.reporter.post_info(depth, b->search_depth);
+    }
+
+    const auto score = search_move<EXACT, true>(root_move.move, singular, depth, move_count, alpha, beta, best_score);
+
+    unmake_move();
+
+    root_move.nodes += t->nodes - nodes;
+
+    if (!score)
+      continue;
+
+    [[unlikely]]
+    if (stopped())
+      return 0;
+
+    if (*score > best_score)
+    {
+      best_score = *score;
+
+      if (best_score > alpha)
+      {
+        best_move = root_move.move;
+
+        if (best_score >= beta)
+        {
+          update_pv<BETA>(best_move, best_score, depth);
+          break;
+        }
+
+        update_pv<EXACT>(best_move, best_score, depth);
+        alpha = best_score;
+      }
+    }
+  }
+
+  [[unlikely]]
+  if (stopped())
+    return 0;
+
+  if (move_count == 0)
+    return b->in_check() ? -MAXSCORE : draw_score();
+
+  if (pos->rule50 >= 100)
+    return draw_score();
+
+  if (best_move && !is_capture(best_move) && !is_promotion(best_move))
+    update_quiet_history(t, pos, best_move, depth);
+
+  return store_search_node_score(best_score, depth, node_type(best_score, beta, best_move), best_move);
+}
+
 template<Searcher SearcherType>
 template<NodeType NT, bool PV>
-int Search<SearcherType>::search(int depth, int alpha, const int beta)
+int Search<SearcherType>::search(int depth, int alpha, const int beta) noexcept
 {
+  [[unlikely]]
+  if (stopped())
+    return 0;
+
   if constexpr (!PV)
   {
-    if (is_hash_score_valid(pos, depth, alpha, beta))
+    if (is_hash_score_valid(pool.tt, pos, depth, alpha, beta))
       return pos->transp_score;
   }
 
@@ -324,61 +598,35 @@ int Search<SearcherType>::search(int depth, int alpha, const int beta)
 
   while (auto *const move_data = mg.next_move())
   {
-    int score;
-
     if (make_move_and_evaluate(move_data->move, alpha, beta))
     {
       ++move_count;
 
-      if constexpr (verbosity)
-      {
-        if (b->plies == 1 && b->search_depth >= 20 && (pool.main()->time.should_post_curr_move() || is_analysing()))
-          uci::post_curr_move(move_data->move, move_count);
-
-        if (pool.main()->time.should_post_info())
-          uci::post_info(depth, b->search_depth);
-      }
-
-      if (PV && move_count == 1)
-        score = search_next_depth<EXACT, true>(next_depth_pv(singular, depth, *move_data), -beta, -alpha);
-      else
-      {
-        const auto next_depth = next_depth_not_pv<NT, PV>(depth, move_count, *move_data, alpha, best_score);
-
-        if (!next_depth)
-        {
-          unmake_move();
-          continue;
-        }
+      if (post_output && pool.main()->timer.should_post_info())
+        pool.reporter.post_info(depth, b->search_depth);
 
-        constexpr auto next_expected_node_type = NT & (EXACT | ALPHA) ? BETA : ALPHA;
+      const auto score = search_move<NT, PV>(move_data->move, singular, depth, move_count, alpha, beta, best_score);
 
-        score = search_next_depth<next_expected_node_type, false>(next_depth.value(), -alpha - 1, -alpha);
-
-        if (score > alpha && depth > 1 && next_depth.value() < depth - 1)
-          score = search_next_depth<next_expected_node_type, false>(depth - 1, -alpha - 1, -alpha);
+      unmake_move();
 
-        if (score > alpha && score < beta)
-          score = search_next_depth<EXACT, true>(next_depth_pv(MOVE_NONE, depth, *move_data), -beta, -alpha);
-      }
+      if (!score)
+        continue;
 
-      unmake_move();
+      [[unlikely]]
+      if (stopped())
+        return 0;
 
-      if (score > best_score)
+      if (*score > best_score)
       {
-        best_score = score;
+        best_score = *score;
 
         if (best_score > alpha)
         {
           best_move = move_data->move;
 
-          if (score >= beta)
-          {
-            if (b->plies == 0)
-              update_pv<BETA>(best_move, best_score, depth);
-
+          if (best_score >= beta)
             break;
-          }
+
           update_pv<EXACT>(best_move, best_score, depth);
           alpha = best_score;
         }
@@ -386,8 +634,9 @@ int Search<SearcherType>::search(int depth, int alpha, const int beta)
     }
   }
 
-  if (pool.stop)
-    throw 1;
+  [[unlikely]]
+  if (stopped())
+    return 0;
 
   if (move_count == 0)
     return b->in_check() ? -MAXSCORE + b->plies : draw_score();
@@ -405,7 +654,34 @@ int Search<SearcherType>::search(int depth, int alpha, const int beta)
 
 template<Searcher SearcherType>
 template<NodeType NT, bool PV>
-int Search<SearcherType>::search_next_depth(const int depth, const int alpha, const int beta)
+std::optional<int> Search<SearcherType>::search_move(
+  const Move m, const Move singular, const int depth, const int move_count, const int alpha, const int beta,
+  int &best_score) noexcept
+{
+  if (PV && move_count == 1)
+    return search_next_depth<EXACT, true>(next_depth_pv(singular, depth, m), -beta, -alpha);
+
+  const auto next_depth = next_depth_not_pv<NT, PV>(depth, move_count, m, alpha, best_score);
+
+  if (!next_depth)
+    return std::nullopt;
+
+  constexpr auto next_expected_node_type = NT & (EXACT | ALPHA) ? BETA : ALPHA;
+
+  auto score = search_next_depth<next_expected_node_type, false>(next_depth.value(), -alpha - 1, -alpha);
+
+  if (score > alpha && depth > 1 && next_depth.value() < depth - 1)
+    score = search_next_depth<next_expected_node_type, false>(depth - 1, -alpha - 1, -alpha);
+
+  if (score > alpha && score < beta)
+    score = search_next_depth<EXACT, true>(next_depth_pv(MOVE_NONE, depth, m), -beta, -alpha);
+
+  return score;
+}
+
+template<Searcher SearcherType>
+template<NodeType NT, bool PV>
+int Search<SearcherType>::search_next_depth(const int depth, const int alpha, const int beta) noexcept
 {
   return (b->is_draw() || b->is_repetition()) && pos->last_move
            ? -draw_score()
@@ -414,7 +690,7 @@ int Search<SearcherType>::search_next_depth(const int depth, const int alpha, co
 
 template<Searcher SearcherType>
 template<bool PV>
-Move Search<SearcherType>::singular_move(const int depth)
+Move Search<SearcherType>::singular_move(const int depth) noexcept
 {
   if constexpr (!PV)
     return MOVE_NONE;
@@ -428,7 +704,7 @@ Move Search<SearcherType>::singular_move(const int depth)
 }
 
 template<Searcher SearcherType>
-auto Search<SearcherType>::search_fail_low(const int depth, int alpha, const Move exclude)
+auto Search<SearcherType>::search_fail_low(const int depth, int alpha, const Move exclude) noexcept
 {
   auto mg = Moves(b);
   mg.generate_moves(pos->transp_move, STAGES);
@@ -438,7 +714,7 @@ auto Search<SearcherType>::search_fail_low(const int depth, int alpha, const Mov
   while (const auto *const move_data = mg.next_move())
   {
     [[unlikely]]
-    if (pool.stop)
+    if (stopped())
       return false;
 
     [[unlikely]]
@@ -523,16 +799,20 @@ int Search<SearcherType>::next_depth_pv(const Move singular_move, const int dept
 
 template<Searcher SearcherType>
 template<bool PV>
-int Search<SearcherType>::search_quiesce(int alpha, const int beta, const int qs_ply)
+int Search<SearcherType>::search_quiesce(int alpha, const int beta, const int qs_ply) noexcept
 {
+  [[unlikely]]
+  if (stopped())
+    return 0;
+
   if constexpr (!PV)
   {
-    if (is_hash_score_valid(pos, 0, alpha, beta))
+    if (is_hash_score_valid(pool.tt, pos, 0, alpha, beta))
       return pos->transp_score;
   }
 
   if (pos->eval_score >= beta)
-    return !pos->transposition || pos->transp_depth <= 0 ? store_search_node_score(pos->eval_score, 0, BETA, MOVE_NONE)
+    return !pos->transp_found || pos->transp_depth <= 0 ? store_search_node_score(pos->eval_score, 0, BETA, MOVE_NONE)
                                                          : pos->eval_score;
 
   if (b->plies >= MAXDEPTH - 1 || qs_ply > 6)
@@ -582,6 +862,10 @@ int Search<SearcherType>::search_quiesce(int alpha, const int beta, const int qs
 
       unmake_move();
 
+      [[unlikely]]
+      if (stopped())
+        return 0;
+
       if (score > best_score)
       {
         best_score = score;
@@ -600,15 +884,22 @@ int Search<SearcherType>::search_quiesce(int alpha, const int beta, const int qs
     }
   }
 
-  return !pos->transposition || pos->transp_depth <= 0
+  return !pos->transp_found || pos->transp_depth <= 0
            ? store_search_node_score(best_score, 0, node_type(best_score, beta, best_move), best_move)
            : best_score;
 }
 
 template<Searcher SearcherType>
-bool Search<SearcherType>::make_move_and_evaluate(const Move m, const int alpha, const int beta)
+bool Search<SearcherType>::make_move_and_evaluate(const Move m, const int alpha, const int beta) noexcept
 {
-  const auto current_nodes = t->node_count.fetch_add(1, std::memory_order_relaxed);
+  [[unlikely]]
+  if (t->count_node() == node_check)
+    check_node_limit();
+
+  // Start loading the hash entries of the child position, the memory latency
+  // is then hidden behind the legality check and the incremental updates
+  prefetch(pool.tt.find_bucket(b->key_after(m)));
+  prefetch(t->pawn_hash[b->pawn_key_after(m)]);
 
   [[unlikely]]
   if (!b->make_move(m, true, true))
@@ -619,9 +910,9 @@ bool Search<SearcherType>::make_move_and_evaluate(const Move m, const int alpha,
   t->pv_length[b->plies] = b->plies;
 
   if constexpr (verbosity)
-    check_sometimes(current_nodes);
+    check_sometimes();
 
-  hash_and_evaluate(pos, b, t->index(), -beta, -alpha, b->plies);
+  hash_and_evaluate(pool.tt, pos, b, t->index(), -beta, -alpha, b->plies);
 
   if (b->plies > b->max_ply)
     b->max_ply = b->plies;
@@ -630,7 +921,7 @@ bool Search<SearcherType>::make_move_and_evaluate(const Move m, const int alpha,
 }
 
 template<Searcher SearcherType>
-void Search<SearcherType>::unmake_move()
+void Search<SearcherType>::unmake_move() noexcept
 {
   b->unmake_move();
   pos = b->pos;
@@ -638,30 +929,52 @@ void Search<SearcherType>::unmake_move()
 }
 
 template<Searcher SearcherType>
-void Search<SearcherType>::check_sometimes(const std::uint64_t nodes) const
+void Search<SearcherType>::check_sometimes() const noexcept
 {
-  if (nodes >= 16383)
+  // the timer thread raises the flag, the clock is only read there
+  [[unlikely]]
+  if (pool.main()->timer.time_up())
     check_time();
 }
 
 template<Searcher SearcherType>
-void Search<SearcherType>::check_time() const
+void Search<SearcherType>::check_time() const noexcept
 {
   if constexpr (verbosity)
   {
-    const auto stop =
-      !is_analysing() && !pool.is_fixed_depth() && b->search_depth > 1 && pool.main()->time.time_up();
+    const auto stop = pool.is_time_managed() && b->search_depth > 1 && pool.main()->timer.time_up();
 
+    // the nodes notice the flag and return to the root
     if (stop)
-    {
       pool.stop = true;
-      throw 1;
-    }
   }
 }
 
 template<Searcher SearcherType>
-bool Search<SearcherType>::is_analysing()
+void Search<SearcherType>::check_node_limit() noexcept
+{
+  // every thread takes its nodes from the budget of the pool in small chunks, so the limit holds for the whole pool
+  constexpr std::uint64_t chunk = 128;
+
+  const auto limit   = pool.limits.nodes;
+  const auto claimed = pool.nodes_claimed.fetch_add(chunk, std::memory_order_relaxed);
+
+  if (claimed < limit)
+  {
+    // the node being counted is the first of the chunk
+    node_check = t->nodes - 1 + std::min(chunk, limit - claimed);
+    return;
+  }
+
+  // the first iteration of the main thread is always completed, so there is a move to play
+  if (std::atomic_ref(pool.main()->completed_depth).load(std::memory_order_relaxed) > 0)
+    pool.stop = true;
+  else
+    node_check = t->nodes;
+}
+
+template<Searcher SearcherType>
+bool Search<SearcherType>::is_analysing() const
 {
   if constexpr (!verbosity)
     return true;
@@ -697,10 +1010,11 @@ void Search<SearcherType>::update_pv(const Move m, const int score, const int de
   {
     pos->pv_length = pv_len[0];
 
-    if constexpr (verbosity)
+    // with several lines they are reported together once the iteration is complete
+    if (post_output && lines == 1)
     {
       const std::span pv_line{pv[ply]};
-      uci::post_pv(b->search_depth, b->max_ply, score, pv_line.subspan(ply, pv_len[ply]), NT);
+      pool.reporter.post_pv(b->search_depth, b->max_ply, score, pv_line.subspan(ply, pv_len[ply]), NT, 0);
     }
   }
 }
@@ -710,7 +1024,18 @@ void Search<SearcherType>::init_search()
 {
   pos            = b->pos;   // Updated in make_move and unmake_move from here on.
   pos->pv_length = 0;
+
+  // plies is the distance from the root, set_fen() initialises it from the move number
+  b->plies = b->max_ply = 0;
   pos->killer_moves.fill(MOVE_NONE);
+
+  init_root_moves();
+
+  // the first node claims the first chunk of the node limit
+  if (pool.limits.nodes > 0)
+    node_check = t->nodes;
+
+  lines = std::clamp<std::size_t>(pool.config.multi_pv, 1, std::max<std::size_t>(root_moves.size(), 1));
 }
 
 template<Searcher SearcherType>
@@ -739,7 +1064,8 @@ void Search<SearcherType>::store_hash(int depth, int score, NodeType nt, Move m)
   else if (nt == EXACT)
     pos->eval_score = score;
 
-  pos->transposition = TT.insert(b->key(), depth, score, nt, m, pos->eval_score);
+  pool.tt.insert(b->key(), depth, score, nt, m, pos->eval_score);
+  pos->transp_found = true;
 }
 
 template<Searcher SearcherType>
@@ -749,7 +1075,7 @@ bool Search<SearcherType>::move_is_easy() const
     return false;
   else
   {
-    if (b->search_depth > 9 && Moves(b).move_count() == 1)
+    if (b->search_depth > 9 && root_moves.size() == 1)
       return true;
 
     [[unlikely]]
@@ -760,7 +1086,111 @@ bool Search<SearcherType>::move_is_easy() const
       return true;
     }
 
-    return !is_analysing() && !pool.is_fixed_depth() && pool.main()->time.plenty_time();
+    // a mate in n moves is found n * 2 - 1 plies from the root
+    [[unlikely]]
+    if (const auto mate = pool.limits.mate; mate > 0 && t->pv[0][0].score >= MAXSCORE - (mate * 2 - 1))
+      return true;
+
+    return pool.is_time_managed() && pool.main()->time.plenty_time();
+  }
+}
+
+template<Searcher SearcherType>
+void Search<SearcherType>::init_root_moves()
+{
+  const auto legal_moves   = MoveList<LEGALMOVES>(b);
+  const auto &search_moves = pool.limits.search_moves;
+
+  // searchmoves only restricts the root when at least one of its moves can be played
+  const auto restricted = std::ranges::any_of(search_moves, [&legal_moves](const Move m) {
+    return legal_moves.contains(m);
+  });
+
+  // the first iteration searches the moves in the order of any other node, later ones order them by their results
+  const auto transposition = pool.tt.find(b->key());
+
+  auto mg = Moves(b);
+  mg.generate_moves(transposition ? transposition->move() : MOVE_NONE, STAGES);
+
+  while (const auto *const move_data = mg.next_move())
+    if (legal_moves.contains(move_data->move)
+        && (!restricted || std::ranges::find(search_moves, move_data->move) != search_moves.end()))
+      root_moves.emplace_back(move_data->move);
+}
+
+template<Searcher SearcherType>
+void Search<SearcherType>::save_root_line()
+{
+  const auto &best = t->pv.front();
+  const auto first = std::next(root_moves.begin(), pv_index);
+
+  const auto it = std::find_if(first, root_moves.end(), [&best](const RootMove &root_move) {
+    return root_move.move == best.front().move;
+  });
+
+  [[unlikely]]
+  if (it == root_moves.end())
+    return;
+
+  // the move takes the place of its line, the moves not searched yet keep their order
+  std::rotate(first, it, std::next(it));
+  first->score = best.front().score;
+  first->pv.assign(best.begin(), std::next(best.begin(), t->pv_length.front()));
+}
+
+template<Searcher SearcherType>
+void Search<SearcherType>::order_root_moves()
+{
+  const auto ranked = std::next(root_moves.begin(), std::min(lines, root_moves.size()));
+
+  // the lines are ranked by score, a later line can score above an earlier one when the search is unstable
+  std::ranges::stable_sort(root_moves.begin(), ranked, std::greater{}, &RootMove::score);
+
+  // the other moves only have a bound, the ones that took the most effort to refute are tried first
+  std::ranges::stable_sort(ranked, root_moves.end(), std::greater{}, &RootMove::nodes);
+}
+
+template<Searcher SearcherType>
+void Search<SearcherType>::restore_best_line()
+{
+  // the root line of the thread is the best one, it is what the result and the voting between threads is based on
+  const auto &pv_line = root_moves.front().pv;
+
+  // save_root_line() keeps no line if the search did not end in a root move, the current line is kept then
+  [[unlikely]]
+  if (pv_line.empty())
+    return;
+
+  std::ranges::copy(pv_line, t->pv.front().begin());
+  t->pv_length.front() = pos->pv_length = static_cast<int>(pv_line.size());
+
+  // the best move is also the last one stored for the root position
+  store_pv(pool.tt, t->pv.front(), t->pv_length.front());
+}
+
+template<Searcher SearcherType>
+void Search<SearcherType>::post_root_lines() const
+{
+  for (std::size_t i = 0; i < lines; ++i)
+  {
+    const auto &root_move = root_moves[i];
+    pool.reporter.post_pv(
+      b->search_depth, b->max_ply, root_move.score, root_move.pv, EXACT, static_cast<int>(i + 1));
+  }
+}
+
+template<Searcher SearcherType>
+void Search<SearcherType>::publish_root_lines() const
+{
+  auto &result_lines = pool.main()->lines;
+  result_lines.resize(lines);
+
+  for (std::size_t i = 0; i < lines; ++i)
+  {
+    const auto &root_move = root_moves[i];
+    result_lines[i].score = root_move.score;
+    result_lines[i].pv.resize(root_move.pv.size());
+    std::ranges::transform(root_move.pv, result_lines[i].pv.begin(), &PVEntry::move);
   }
 }
 
@@ -773,43 +1203,73 @@ void thread::search()
 
 void main_thread::search()
 {
+  const auto post_output = pool.config.uci_output;
+
   // initialize
-  TT.init_search();
+  pool.tt.init_search();
+  lines.clear();
 
   //
   // If book is enabled and we succesfully can probe for a move, perform the move
   //
-  if (Options[uci::uci_name<uci::UciOptions::USE_BOOK>()])
+  if (pool.config.use_book && !book.empty())
   {
-      if (const auto book_file = Options[uci::uci_name<uci::UciOptions::BOOKS>()]; !book.empty())
-      {
-        if (const auto book_move = book.probe(root_board.get()); book_move)
-        {
-          uci::post_moves(book_move, MOVE_NONE);
-          return;
-        }
-      }
+    if (const auto book_move = book.probe(root_board.get(), pool.config.book_best_move); book_move)
+    {
+      pool.result.best_move = book_move;
+
+      if (post_output)
+        uci::post_moves(book_move, MOVE_NONE);
+      return;
+    }
   }
 
   time.init(root_board->side_to_move(), pool.limits);
+  timer.start(time);
 
   pool.start_searching();   // start workers
   Search<Searcher::Master>(root_board.get()).go();
 
-  while (!pool.stop && (ponder || pool.limits.infinite))
-  {
-    // "wait" until stopped
-  }
+  // when pondering or analysing, the search only ends at stop or ponderhit
+  wait_for_stop();
 
   pool.stop = true;
+  timer.stop();
 
   // Wait until all threads have finished
   pool.wait_for_search_finished();
 
+  if (post_output)
+  {
+    // the lines of the search are written before anything else is printed
+    pool.reporter.flush();
+    uci::post_eval_cache_info(pool);
+    pool.tt.post_stats(false);
+  }
+
+  auto *best = best_thread(pool);
+
   [[likely]]
-  if (root_board->pos->pv_length)
+  if (const auto root_pv_length = best->root_board->pos->pv_length; root_pv_length)
   {
-    const auto ponder_move = root_board->pos->pv_length > 1 ? pv[0][1].move : MOVE_NONE;
-    uci::post_moves(pv[0][0].move, ponder_move);
+    const auto ponder_move = root_pv_length > 1 ? best->pv[0][1].move : MOVE_NONE;
+
+    pool.result = {
+      best->pv[0][0].move, ponder_move, best->pv[0][0].score, best->completed_depth, pool.node_count(), lines};
+
+    if (post_output)
+    {
+      // Send the line of the selected helper, the GUI has only seen the lines of the main thread
+      if (best != this)
+      {
+        const std::span pv_line{best->pv[0]};
+        pool.reporter.post_pv(
+          best->completed_depth, best->root_board->max_ply, best->pv[0][0].score, pv_line.first(root_pv_length),
+          EXACT, 0);
+        pool.reporter.flush();
+      }
+
+      uci::post_moves(best->pv[0][0].move, ponder_move);
+    }
   }
 }
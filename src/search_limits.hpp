@@ -21,6 +21,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <vector>
 
 #include "miscellaneous.hpp"
@@ -33,6 +34,8 @@ struct SearchLimits final
   TimeUnit movetime{};
   int movestogo{};
   int depth{};
+  std::uint64_t nodes{};   // the number of nodes to search, 0 for no limit
+  int mate{};              // the search ends when a mate in this many moves is found, 0 for no limit
   bool ponder{};
   bool infinite{};
   bool fixed_movetime{};
@@ -44,8 +47,27 @@ struct SearchLimits final
     time.fill(0);
     inc.fill(0);
     movetime  = 0;
-    movestogo = depth = 0;
+    movestogo = depth = mate = 0;
+    nodes     = 0;
     ponder = infinite = fixed_movetime = fixed_depth = false;
     search_moves.clear();
   }
 };
+
+/// A root move with the score and line it got in the last completed iteration
+struct SearchLine final
+{
+  int score{};
+  std::vector<Move> pv{};
+};
+
+/// The outcome of a finished search, taken from the thread selected as best
+struct SearchResult final
+{
+  Move best_move{};
+  Move ponder_move{};
+  int score{};
+  int depth{};
+  std::uint64_t nodes{};
+  std::vector<SearchLine> lines{};   // the MultiPV lines of the main thread, best first
+};
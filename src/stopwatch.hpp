@@ -24,38 +24,46 @@
 
 #include "miscellaneous.hpp"
 
+/// Measures time on the monotonic clock, so changes to the wall clock do not affect it
 struct Stopwatch final
 {
+  using Clock = std::chrono::steady_clock;
 
-  Stopwatch() : start_time_(std::chrono::system_clock::now()), running_(true)
+  Stopwatch() : start_time_(Clock::now()), running_(true)
   { }
 
   void start()
   {
-    start_time_ = std::chrono::system_clock::now();
+    start_time_ = Clock::now();
     running_    = true;
   }
 
   void stop()
   {
-    end_time_ = std::chrono::system_clock::now();
+    end_time_ = Clock::now();
     running_  = false;
   }
 
   [[nodiscard]]
   TimeUnit elapsed_milliseconds() const
   {
-    const auto end_time = running_ ? std::chrono::system_clock::now() : end_time_;
+    const auto end_time = running_ ? Clock::now() : end_time_;
     return std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time_).count();
   }
 
   [[nodiscard]]
   TimeUnit elapsed_microseconds() const
   {
-    const auto end_time = running_ ? std::chrono::system_clock::now() : end_time_;
+    const auto end_time = running_ ? Clock::now() : end_time_;
     return std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time_).count();
   }
 
+  [[nodiscard]]
+  Clock::time_point started() const
+  {
+    return start_time_;
+  }
+
   [[nodiscard]]
   TimeUnit elapsed_seconds() const
   {
@@ -63,8 +71,8 @@ struct Stopwatch final
   }
 
 private:
-  std::chrono::time_point<std::chrono::system_clock> start_time_;
-  std::chrono::time_point<std::chrono::system_clock> end_time_;
-  std::chrono::time_point<std::chrono::system_clock> last_curr_info_;
+  Clock::time_point start_time_;
+  Clock::time_point end_time_;
+  Clock::time_point last_curr_info_;
   bool running_;
 };
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <utility>
 
 #include "time.hpp"
 
@@ -30,18 +31,10 @@ constexpr TimeUnit time_reserve = 72;
 constexpr std::chrono::milliseconds curr_move_post_limit(5000);
 constexpr std::chrono::milliseconds last_post_info_span(1000);
 
-inline std::chrono::milliseconds since_epoch()
-{
-  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
-}
-
 }   // namespace
 
 void Time::init(const Color c, SearchLimits &limits)
 {
-
-  last_curr_post = last_post_info = since_epoch();
-
   start_time.start();
   [[unlikely]]
   if (limits.fixed_movetime)
@@ -51,34 +44,36 @@ void Time::init(const Color c, SearchLimits &limits)
     const auto moves_left = util::in_between<1, 30>(limits.movestogo) ? limits.movestogo : 30;
     const auto time_left  = limits.time[c];
     const auto time_inc   = limits.inc[c];
+    TimeUnit budget;
 
     [[unlikely]]
     if (time_inc == 0 && time_left < 1000)
     {
-      search_time = time_left / (moves_left * 2);
-      n_          = 1;
+      budget = time_left / (moves_left * 2);
+      n_     = 1;
     } else
     {
-      search_time = 2 * (time_left / (moves_left + 1) + time_inc);
-      n_          = 2.5;
+      budget = 2 * (time_left / (moves_left + 1) + time_inc);
+      n_     = 2.5;
     }
-    search_time = std::max<TimeUnit>(0, std::min<int>(search_time, time_left - time_reserve));
+    search_time = std::max<TimeUnit>(0, std::min<int>(budget, time_left - time_reserve));
   }
 }
 
 bool Time::time_up() const noexcept
 {
-  return start_time.elapsed_milliseconds() > search_time;
+  return start_time.elapsed_milliseconds() > search_time.load(std::memory_order_relaxed);
 }
 
 bool Time::plenty_time() const noexcept
 {
-  return search_time < start_time.elapsed_milliseconds() * n_;
+  return search_time.load(std::memory_order_relaxed) < start_time.elapsed_milliseconds() * n_;
 }
 
 void Time::ponder_hit() noexcept
 {
-  search_time += start_time.elapsed_milliseconds();
+  // the time spent pondering was the opponent's, the full budget is left from here
+  search_time.fetch_add(start_time.elapsed_milliseconds(), std::memory_order_relaxed);
 }
 
 TimeUnit Time::elapsed() const noexcept
@@ -86,20 +81,80 @@ TimeUnit Time::elapsed() const noexcept
   return start_time.elapsed_milliseconds();
 }
 
-bool Time::should_post_curr_move() noexcept
+Stopwatch::Clock::time_point Time::deadline() const noexcept
+{
+  return start_time.started() + std::chrono::milliseconds(search_time.load(std::memory_order_relaxed));
+}
+
+void SearchTimer::start(const Time &time)
+{
+  stop();
+
+  time_up_        = false;
+  post_info_      = false;
+  post_curr_move_ = false;
+  woken_          = false;
+
+  worker_ = std::jthread([this, &time](const std::stop_token token) {
+    run(token, time);
+  });
+}
+
+void SearchTimer::stop()
+{
+  if (!worker_.joinable())
+    return;
+
+  worker_.request_stop();
+  worker_.join();
+}
+
+void SearchTimer::wake()
 {
-  const auto now = since_epoch();
-  const auto can_post = now - last_curr_post > curr_move_post_limit;
-  if (can_post)
-    last_curr_post = now;
-  return can_post;
+  std::lock_guard<std::mutex> lk(mutex_);
+
+  // the deadline only moves later, so the flag can be lowered before the timer has looked at the new one
+  time_up_ = false;
+  woken_   = true;
+  cv_.notify_one();
 }
 
-bool Time::should_post_info() noexcept
+void SearchTimer::run(const std::stop_token &token, const Time &time)
 {
-  const auto now = since_epoch();
-  const auto can_post = now - last_post_info > last_post_info_span;
-  if (can_post)
-    last_post_info = now;
-  return can_post;
-}
\ No newline at end of file
+  using Clock = Stopwatch::Clock;
+
+  auto next_info      = Clock::now() + last_post_info_span;
+  auto next_curr_move = Clock::now() + curr_move_post_limit;
+
+  std::unique_lock<std::mutex> lk(mutex_);
+
+  while (!token.stop_requested())
+  {
+    const auto now      = Clock::now();
+    const auto deadline = time.deadline();
+
+    // read again on every wake up, the deadline moves when a ponder search turns into a normal one
+    time_up_.store(now > deadline, std::memory_order_relaxed);
+
+    if (now >= next_info)
+    {
+      post_info_.store(true, std::memory_order_relaxed);
+      next_info = now + last_post_info_span;
+    }
+
+    if (now >= next_curr_move)
+    {
+      post_curr_move_.store(true, std::memory_order_relaxed);
+      next_curr_move = now + curr_move_post_limit;
+    }
+
+    auto wake_up = std::min(next_info, next_curr_move);
+
+    if (now <= deadline)
+      wake_up = std::min(wake_up, deadline + std::chrono::milliseconds(1));
+
+    cv_.wait_until(lk, token, wake_up, [this] {
+      return std::exchange(woken_, false);
+    });
+  }
+}
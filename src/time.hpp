@@ -20,6 +20,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
 #include "stopwatch.hpp"
 #include "miscellaneous.hpp"
 #include "search_limits.hpp"
@@ -35,20 +41,72 @@ struct Time final
   [[nodiscard]]
   bool plenty_time() const noexcept;
 
+  /// ponder_hit() turns a ponder search into a normal one, its time counts from now
   void ponder_hit() noexcept;
 
   [[nodiscard]]
   TimeUnit elapsed() const noexcept;
 
+  /// deadline() is the point in time where time_up() becomes true
   [[nodiscard]]
-  bool should_post_curr_move() noexcept;
-
-  bool should_post_info() noexcept;
+  Stopwatch::Clock::time_point deadline() const noexcept;
 
 private:
   Stopwatch start_time{};
   double n_{};
-  TimeUnit search_time{};
-  std::chrono::milliseconds last_curr_post{};
-  std::chrono::milliseconds last_post_info{};
+  std::atomic<TimeUnit> search_time{};   // moved by ponder_hit() while the search and the timer read it
+};
+
+/// A thread that keeps the clock while the main thread searches. It raises flags when the time is up and when it is
+/// time to post info, so the search only has to test them instead of reading the clock in every node.
+struct SearchTimer final
+{
+  /// start() starts the timer thread for a search with the given time
+  void start(const Time &time);
+
+  /// stop() stops the timer thread and waits for it to finish
+  void stop();
+
+  /// wake() makes the timer look at the time again, used when the deadline has been moved later
+  void wake();
+
+  [[nodiscard]]
+  bool time_up() const noexcept
+  {
+    return time_up_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]]
+  bool should_post_info() noexcept
+  {
+    return take(post_info_);
+  }
+
+  [[nodiscard]]
+  bool should_post_curr_move() noexcept
+  {
+    return take(post_curr_move_);
+  }
+
+private:
+  void run(const std::stop_token &token, const Time &time);
+
+  /// take() clears the flag if it is raised, the load keeps the cache line shared while it is not
+  [[nodiscard]]
+  static bool take(std::atomic_bool &flag) noexcept
+  {
+    if (!flag.load(std::memory_order_relaxed))
+      return false;
+
+    flag.store(false, std::memory_order_relaxed);
+    return true;
+  }
+
+  std::atomic_bool time_up_{};
+  std::atomic_bool post_info_{};
+  std::atomic_bool post_curr_move_{};
+  std::mutex mutex_;
+  std::condition_variable_any cv_;
+  bool woken_{};
+  std::jthread worker_;
 };
@@ -21,10 +21,12 @@
 #include <numeric>
 #include <execution>
 
+#include <fmt/format.h>
+
 #include "tpool.hpp"
-#include "uci.hpp"
 #include "board.hpp"
 #include "transpositional.hpp"
+#include "numa.hpp"
 
 namespace
 {
@@ -33,13 +35,17 @@ constexpr std::size_t parallel_threshold = 8;
 
 }
 
-thread::thread(const std::size_t index)
-  : root_board(std::make_unique<Board>()), idx(index), jthread(&thread::idle_loop, this), searching(true)
-{ }
+thread::thread(const std::size_t index, thread_pool &owner)
+  : pool(owner), root_board(std::make_unique<Board>()), idx(index), searching(true), jthread(&thread::idle_loop, this)
+{
+  // make sure the thread has reached idle_loop() before it can be signalled
+  wait_for_search_finished();
+}
 
 thread::~thread()
 {
-  assert(!searching.load());
+  // the thread can still be on its way back from search() when the pool is resized right after a bestmove
+  wait_for_search_finished();
 
   exit.store(true);
   start_searching();
@@ -50,15 +56,14 @@ void thread::clear_data()
   std::memset(history_scores.data(), 0, sizeof history_scores);
   std::memset(counter_moves.data(), 0, sizeof counter_moves);
   pv_length.fill(0);
-  pv.fill({});
+  pv.clear();
   draw_score.fill(0);
 }
 
 void thread::idle_loop()
 {
-  // NUMA fix
-  if (Options[uci::uci_name<uci::UciOptions::THREADS>()] > 8)
-    WinProcGroup::bind_this_thread(idx);
+  // Pin the thread before it allocates anything on its own
+  pool.placement.bind_this_thread(idx);
 
   do
   {
@@ -97,12 +102,43 @@ void thread::wait_for_search_finished()
   });
 }
 
+void main_thread::set_ponder(const bool v)
+{
+  ponder = v;
+  wake();
+}
+
+void main_thread::ponder_hit()
+{
+  time.ponder_hit();
+
+  // the timer lowers its flag at once, the search must not stop on the deadline it had while pondering
+  timer.wake();
+  set_ponder(false);
+}
+
+void main_thread::wake()
+{
+  // taking the lock makes sure the main thread is either waiting or has not checked the condition yet
+  std::lock_guard<std::mutex> lk(stop_mutex);
+  stop_cv.notify_one();
+}
+
+void main_thread::wait_for_stop()
+{
+  std::unique_lock<std::mutex> lk(stop_mutex);
+  stop_cv.wait(lk, [&] {
+    return pool.stop || !(ponder || pool.limits.infinite);
+  });
+}
+
 #if defined(linux)
-thread_pool::thread_pool()
+thread_pool::thread_pool(HashTable &table) : tt(table)
 { }
 #else
-thread_pool::thread_pool()
-  : node_counters(
+thread_pool::thread_pool(HashTable &table)
+  : tt(table)
+  , node_counters(
     {[&] {
        return node_count_seq();
      },
@@ -114,26 +150,43 @@ thread_pool::thread_pool()
 
 void thread_pool::set(const std::size_t v)
 {
-  while (!empty())
-    pop_back();
-
   assert(v > 0);
 
+  if (!empty())
+    main()->wait_for_search_finished();
+
+  // The threads are kept alive, only the difference is removed or created.
+  // A thread pins itself when it starts, so all of them are recreated if a running thread has to move.
+  if (placement.configure(config.thread_binding, v))
+    clear();
+
+  while (size() > v)
+    pop_back();
+
   if (v > 0)
   {
-    emplace_back(std::make_unique<main_thread>(0));
-
+    // Place the data of each new thread on the node it will be running on
     while (size() < v)
-      emplace_back(std::make_unique<thread>(size()));
+    {
+      const numa::PreferredNode preferred(placement.node(size()));
 
-    clear_data();
+      if (empty())
+        emplace_back(std::make_unique<main_thread>(0, *this));
+      else
+        emplace_back(std::make_unique<thread>(size(), *this));
 
-    auto tt_size = static_cast<std::size_t>(Options[uci::uci_name<uci::UciOptions::HASH>()]);
+      back()->eval_cache.resize(config.eval_cache_mb);
+      back()->pawn_hash.resize(config.pawn_hash_mb);
+    }
 
-    if (Options[uci::uci_name<uci::UciOptions::HASH_X_THREADS>()])
+    auto tt_size = config.hash_mb;
+
+    if (config.hash_x_threads)
       tt_size *= size();
 
-    TT.init(tt_size);
+    tt.set_thread_count(size(), &placement);
+    if (tt.init(tt_size) && config.uci_output)
+      fmt::print("info string {}\n", tt.page_info());
 
 #if !defined(linux)
     parallel = size() > parallel_threshold;
@@ -148,10 +201,17 @@ void thread_pool::start_thinking(std::string_view fen)
   front_thread->wait_for_search_finished();
 
   stop                 = false;
+  nodes_claimed        = 0;
+  result               = {};
   front_thread->ponder = limits.ponder;
 
-  const auto setup = [&fen](std::unique_ptr<thread> &t) {
-    t->node_count = 0;
+  const auto setup = [&fen, this](std::unique_ptr<thread> &t) {
+    t->nodes             = 0;
+    t->node_count.value  = 0;
+    t->completed_depth   = 0;
+    t->eval_cache.probes = 0;
+    t->eval_cache.hits   = 0;
+    t->noise_seed        = config.ordering_noise ? static_cast<std::uint32_t>(t->index()) : 0;
     t->root_board->set_fen(fen, t.get());
   };
 
@@ -180,17 +240,33 @@ void thread_pool::wait_for_search_finished()
   std::for_each(std::next(begin()), end(), wait);
 }
 
+void thread_pool::request_stop()
+{
+  stop = true;
+
+  if (!empty())
+    main()->wake();
+}
+
 void thread_pool::clear_data()
 {
+  // Clear the search data in parallel and from the cpu each thread is pinned to, so the pages stay on its node.
+  // The pawn hash and eval cache are kept, their entries are verified by the full key and do not depend on the game.
+  std::vector<std::jthread> clearers;
+  clearers.reserve(size());
+
   for (auto &w : *this)
-    w->clear_data();
+    clearers.emplace_back([&w] {
+      w->pool.placement.bind_this_thread(w->index());
+      w->clear_data();
+    });
 }
 
 std::uint64_t thread_pool::node_count() const
 {
 #if defined(linux)
   const auto accumulator = [](const std::uint64_t r, const std::unique_ptr<thread> &d) {
-    return r + d->node_count.load(std::memory_order_relaxed);
+    return r + d->node_count.value.load(std::memory_order_relaxed);
   };
   return std::accumulate(cbegin(), cend(), 0ull, accumulator);
 #else
@@ -198,11 +274,16 @@ std::uint64_t thread_pool::node_count() const
 #endif
 }
 
+std::uint64_t thread_pool::node_count(const thread &caller) const
+{
+  return node_count() - caller.node_count.value.load(std::memory_order_relaxed) + caller.nodes;
+}
+
 #if !defined(linux)
 std::uint64_t thread_pool::node_count_seq() const
 {
   const auto accumulator = [](const std::uint64_t r, const std::unique_ptr<thread> &d) {
-    return r + d->node_count.load(std::memory_order_relaxed);
+    return r + d->node_count.value.load(std::memory_order_relaxed);
   };
   return std::accumulate(cbegin(), cend(), 0ull, accumulator);
 }
@@ -210,7 +291,7 @@ std::uint64_t thread_pool::node_count_seq() const
 std::uint64_t thread_pool::node_count_par() const
 {
   const auto accumulator = [](const std::unique_ptr<thread> &d) {
-    return d->node_count.load(std::memory_order_relaxed);
+    return d->node_count.value.load(std::memory_order_relaxed);
   };
   return std::transform_reduce(std::execution::par_unseq, cbegin(), cend(), 0ull, std::plus<>(), accumulator);
 }
@@ -30,17 +30,32 @@
 #include <vector>
 #include <functional>
 
+#include "engine_config.hpp"
 #include "pawnhashtable.hpp"
+#include "eval_cache.hpp"
+#include "miscellaneous.hpp"
+#include "numa.hpp"
 #include "pv_entry.hpp"
+#include "reporter.hpp"
 #include "time.hpp"
 #include "types.hpp"
 
 /// Main thread pool header
 /// Contains pool, thread and main_thread
 
+struct HashTable;
+struct thread_pool;
+
 using HistoryScores = std::array<std::array<int, SQ_NB>, 16>;
 using CounterMoves  = std::array<std::array<Move, SQ_NB>, 16>;
 
+/// A counter written by one thread and read by others, kept alone on its cache line so
+/// the reads do not slow down the writes to the data next to it
+struct alignas(CacheLineSize) PublishedCounter final
+{
+  std::atomic_uint64_t value{};
+};
+
 enum class Searcher
 {
   Master,
@@ -49,7 +64,7 @@ enum class Searcher
 
 struct thread
 {
-  explicit thread(std::size_t index);
+  thread(std::size_t index, thread_pool &owner);
   virtual ~thread();
   thread(const thread &other) = delete;
   thread(thread &&other)      = delete;
@@ -62,18 +77,48 @@ struct thread
   void start_searching();
   void wait_for_search_finished();
 
+  /// count_node() counts a searched node and makes the count visible to other threads once in a while.
+  /// Returns the node count before this node.
+  std::uint64_t count_node() noexcept
+  {
+    constexpr std::uint64_t publish_interval = 1024;
+
+    if (nodes % publish_interval == 0)
+      node_count.value.store(nodes, std::memory_order_relaxed);
+
+    return nodes++;
+  }
+
+  void publish_nodes() noexcept
+  {
+    node_count.value.store(nodes, std::memory_order_relaxed);
+  }
+
   [[nodiscard]]
   std::size_t index() const
   {
     return idx;
   }
 
+  /// ordering_noise() returns a small offset for the score of a quiet move, which is different for each thread and
+  /// makes helper threads search the moves in a slightly different order. Zero when the noise is disabled.
+  [[nodiscard]]
+  int ordering_noise(const Move m) const noexcept
+  {
+    return noise_seed ? static_cast<int>(((static_cast<std::uint32_t>(m) ^ noise_seed) * 0x9e3779b1u) >> 27) : 0;
+  }
+
+  thread_pool &pool;   // the pool of the engine instance this thread belongs to
   PawnHashTable pawn_hash{};
+  EvalCache eval_cache{};
+  std::uint32_t noise_seed{};
   HistoryScores history_scores{};
   CounterMoves counter_moves{};
-  std::array<std::array<PVEntry, MAXDEPTH>, MAXDEPTH> pv{};
+  PVTable pv{};
   std::array<int, MAXDEPTH> pv_length{};
-  std::atomic_uint64_t node_count;
+  std::uint64_t nodes{};   // only touched by the searching thread
+  int completed_depth{};
+  PublishedCounter node_count{};
   std::condition_variable waiter;
   std::unique_ptr<Board> root_board{};
   std::array<int, COL_NB> draw_score{};
@@ -82,9 +127,9 @@ private:
   std::mutex mutex;
   std::condition_variable cv;
   std::size_t idx;
-  std::jthread jthread;
   std::atomic_bool exit{};
   std::atomic_bool searching{};
+  std::jthread jthread;
 };
 
 struct main_thread final : thread
@@ -93,13 +138,30 @@ struct main_thread final : thread
 
   void search() override;
 
+  /// set_ponder() changes the ponder state and wakes up the main thread if it is waiting for the search to end
+  void set_ponder(bool v);
+
+  /// wake() wakes up the main thread if it is waiting for stop or the end of pondering
+  void wake();
+
+  /// ponder_hit() turns the running ponder search into a timed search for the move, keeping what it has searched
+  void ponder_hit();
+
   std::atomic_bool ponder;
+  std::vector<SearchLine> lines{};   // the root lines of the last completed iteration, best first
   Time time{};
+  SearchTimer timer{};   // declared after time, which it reads
+
+private:
+  void wait_for_stop();
+
+  std::mutex stop_mutex;
+  std::condition_variable stop_cv;
 };
 
 struct thread_pool final : std::vector<std::unique_ptr<thread>>
 {
-  thread_pool();
+  explicit thread_pool(HashTable &table);
   ~thread_pool()                        = default;
   thread_pool(const thread_pool &other) = delete;
   thread_pool(thread_pool &&other)      = delete;
@@ -112,6 +174,9 @@ struct thread_pool final : std::vector<std::unique_ptr<thread>>
   void start_searching();
   void wait_for_search_finished();
 
+  /// request_stop() stops the search and wakes up the main thread
+  void request_stop();
+
   [[nodiscard]]
   main_thread *main() const
   {
@@ -123,10 +188,15 @@ struct thread_pool final : std::vector<std::unique_ptr<thread>>
   [[nodiscard]]
   std::uint64_t node_count() const;
 
+  /// node_count() with the exact count of the calling thread in place of the count it has published
+  [[nodiscard]]
+  std::uint64_t node_count(const thread &caller) const;
+
   [[nodiscard]]
   bool is_analysing() const noexcept
   {
-    return limits.infinite | limits.ponder;
+    // a ponder search stops analysing at ponderhit
+    return limits.infinite || main()->ponder.load(std::memory_order_relaxed);
   }
 
   [[nodiscard]]
@@ -141,8 +211,23 @@ struct thread_pool final : std::vector<std::unique_ptr<thread>>
     return limits.depth;
   }
 
+  /// is_time_managed() tells if the clock ends the search. A search to a fixed depth, or for a number of nodes or a
+  /// mate without any time given, only ends at its limit.
+  [[nodiscard]]
+  bool is_time_managed() const noexcept
+  {
+    const auto has_clock = limits.fixed_movetime || limits.time[WHITE] > 0 || limits.time[BLACK] > 0;
+    return !is_analysing() && !limits.fixed_depth && (has_clock || (limits.nodes == 0 && limits.mate == 0));
+  }
+
+  HashTable &tt;
+  numa::Placement placement{};   // the cpus the threads are pinned to
+  EngineConfig config{};
   SearchLimits limits{};
+  SearchResult result{};
   std::atomic_bool stop;
+  std::atomic_uint64_t nodes_claimed{};   // the nodes of the go nodes limit handed out to the threads
+  Reporter reporter{*this};   // writes the output of the main thread
 
 #if !defined(linux)
 private:
@@ -156,6 +241,3 @@ private:
   const std::array<std::function<std::uint64_t()>, 2> node_counters;
 #endif
 };
-
-// global data object
-inline thread_pool pool;
@@ -23,88 +23,385 @@
 #include <cstdlib>
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <cmath>
 
 #include <fmt/format.h>
 
 #include "pv_entry.hpp"
 #include "transpositional.hpp"
-#include "uci.hpp"
+#include "numa.hpp"
 
 namespace
 {
 
-constexpr std::uint32_t key32(const Key key)
+// The bucket is selected by the upper bits of the key, the entry verifies the lower bits
+constexpr std::uint16_t key16(const Key key)
 {
-  return key >> 32;
+  return static_cast<std::uint16_t>(key);
+}
+
+constexpr int HintBits = 6;
+
+// The two bits above the hints mark which clear the bucket has been through, and that a thread is zeroing it
+constexpr std::uint32_t ClearMarkBit = 1u << 31;
+constexpr std::uint32_t ZeroingBit   = 1u << 30;
+
+/// hint() returns the position of the key inside its bucket, as the most significant
+/// bits of the fractional part of key * bucket_count / 2^64
+constexpr std::uint32_t hint(const Key key, const std::size_t bucket_count)
+{
+  return static_cast<std::uint32_t>((key * bucket_count) >> (64 - HintBits));
+}
+
+struct HashFileHeader final
+{
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint32_t entry_size;
+  std::uint64_t bucket_size;
+  std::uint64_t bucket_count;
+  std::int32_t age;
+};
+
+constexpr std::array<char, 8> HashFileMagic{'F', 'C', 'H', 'A', 'S', 'H', '\0', '\0'};
+constexpr std::uint32_t HashFileVersion = 2;
+
+// The buckets start at a page boundary so the file can be mapped directly as the table
+constexpr std::size_t HashFileHeaderSize = 4096;
+
+static_assert(sizeof(HashFileHeader) <= HashFileHeaderSize);
+
+/// parallel_for() splits count buckets evenly between thread_count threads and
+/// calls f(start, len) for each part from its own thread
+
+template<typename Func>
+void parallel_for(const std::size_t count, const std::size_t thread_count, const numa::Placement *placement, Func f)
+{
+  std::vector<std::jthread> threads;
+  threads.reserve(thread_count);
+
+  for (std::size_t idx = 0; idx < thread_count; idx++)
+  {
+    threads.emplace_back([idx, thread_count, count, placement, &f]() {
+      // Thread binding gives faster search on systems with a first-touch policy
+      if (placement)
+        placement->bind_this_thread(idx);
+
+      const auto stride = count / thread_count, start = stride * idx,
+                 len = idx != thread_count - 1 ? stride : count - start;
+
+      f(start, len);
+    });
+  }
 }
 
 }   // namespace
 
 HashTable::~HashTable()
 {
-  std::free(mem_);
+  wait_for_clear();
+  memory::free_large(mem_);
 }
 
-void HashTable::init(const std::uint64_t new_size_mb)
+bool HashTable::init(const std::uint64_t new_size_mb)
 {
   if (size_mb_ == new_size_mb)
-    return;
+    return false;
 
-  // Original code from SF
+  wait_for_clear();
 
-  bucket_count_     = new_size_mb * 1024 * 1024 / sizeof(Bucket);
-  fullness_element_ = bucket_count_ * BucketSize;
-  std::free(mem_);
-  size_ = bucket_count_ * sizeof(Bucket) + CacheLineSize - 1;
-  // TODO : replace with std::aligned_alloc() at some point;
-  mem_ = std::malloc(size_);
+  const auto new_bucket_count = new_size_mb * 1024 * 1024 / sizeof(Bucket);
+  auto block                  = memory::alloc_large(new_bucket_count * sizeof(Bucket));
 
-  if (!mem_)
+  if (!block.ptr)
   {
     fmt::print(stderr, "Failed to allocate {}MB for transposition table.\n", new_size_mb);
     exit(EXIT_FAILURE);
   }
 
-  table_   = reinterpret_cast<Bucket *>((uintptr_t(mem_) + CacheLineSize - 1) & ~(CacheLineSize - 1));
+  // Keep the current table until its entries have been moved to the new one
+  auto old_mem             = std::exchange(mem_, block);
+  auto *const old_table    = std::exchange(table_, static_cast<Bucket *>(mem_.ptr));
+  const auto old_bucket_count = std::exchange(bucket_count_, new_bucket_count);
+
   size_mb_ = new_size_mb;
+
+#if defined(TT_STATS)
+  keys_.assign(bucket_count_ * BucketSize, 0);
+#endif
+
   clear();
+
+  if (old_table && bucket_count_)
+    rehash(old_table, old_bucket_count);
+
+  memory::free_large(old_mem);
+
+  return true;
+}
+
+std::string HashTable::page_info() const
+{
+  if (mem_.nodes > 1)
+    return fmt::format(
+      "Hash {}MB using {} pages, interleaved over {} NUMA nodes", size_mb_, memory::page_size_name(mem_), mem_.nodes);
+
+  return fmt::format("Hash {}MB using {} pages", size_mb_, memory::page_size_name(mem_));
 }
 
 void HashTable::clear()
 {
+  wait_for_clear();
+
   // Original code from SF
+  parallel_for(bucket_count_, thread_count_, placement_, [this](const std::size_t start, const std::size_t len) {
+    // treat as void* to shut up compiler warning -Wclass-memaccess as this is "totally" safe
+    std::memset(reinterpret_cast<void *>(&table_[start]), 0, len * sizeof(Bucket));
+  });
 
-  const auto thread_count = static_cast<std::size_t>(Options[uci::uci_name<uci::UciOptions::THREADS>()]);
-  std::vector<std::jthread> threads(thread_count);
+  clear_mark_ = 0;
 
-  for (std::size_t idx = 0; idx < thread_count; idx++)
+#if defined(TT_STATS)
+  std::ranges::fill(keys_, 0);
+#endif
+}
+
+void HashTable::clear_async()
+{
+  wait_for_clear();
+
+  age_++;
+
+  // every bucket still carrying the previous mark holds only entries written before this clear
+  clear_mark_ ^= ClearMarkBit;
+
+  clearer_ = std::make_unique<std::jthread>([this] {
+    for (std::size_t i = 0; i < bucket_count_; ++i)
+      zero_bucket(&table_[i]);
+  });
+}
+
+void HashTable::wait_for_clear()
+{
+  if (!clearer_)
+    return;
+
+  clearer_->join();
+  clearer_.reset();
+}
+
+bool HashTable::is_pending(Bucket *bucket) const
+{
+  return (std::atomic_ref(bucket->hints).load(std::memory_order_acquire) & (ClearMarkBit | ZeroingBit)) != clear_mark_;
+}
+
+bool HashTable::zero_bucket(Bucket *bucket) const
+{
+  auto hints = std::atomic_ref(bucket->hints);
+  auto h     = hints.load(std::memory_order_acquire);
+
+  while ((h & ClearMarkBit) != clear_mark_)
   {
-    threads.emplace_back(std::jthread([this, idx, thread_count]() {
-      // Thread binding gives faster search on systems with a first-touch policy
-      if (thread_count > 8)
-        WinProcGroup::bind_this_thread(idx);
+    // another thread is zeroing the bucket
+    if (h & ZeroingBit)
+      return false;
 
-      // Each thread will zero its part of the hash table
-      const auto stride = bucket_count_ / thread_count, start = stride * idx,
-                 len = idx != thread_count - 1 ? stride : bucket_count_ - start;
+    if (hints.compare_exchange_weak(h, h | ZeroingBit, std::memory_order_acquire))
+    {
+      for (auto &slot : bucket->entry)
+        slot.reset();
 
-      // treat as void* to shut up compiler warning -Wclass-memaccess as this is "totally" safe
-      std::memset(reinterpret_cast<void *>(&table_[start]), 0, len * sizeof(Bucket));
-    }));
+      hints.store(clear_mark_, std::memory_order_release);
+      return true;
+    }
   }
+
+  return true;
 }
 
-HashEntry *HashTable::find(const Key key) const
+void HashTable::rehash(Bucket *from, const std::size_t from_count)
 {
-  auto *bucket     = find_bucket(key);
-  const auto k32   = key32(key);
-  const auto found = std::ranges::find_if(bucket->entry.begin(), bucket->entry.end(), [&k32](const HashEntry &e) {
-    return e.k == k32 && e.f;
+  parallel_for(from_count, thread_count_, placement_, [&](const std::size_t start, const std::size_t len) {
+    for (auto i = start; i < start + len; ++i)
+    {
+      const auto hints = from[i].hints;
+
+      for (std::size_t j = 0; j < BucketSize; ++j)
+      {
+        const auto e = from[i].entry[j].load();
+
+        if (e.flags() == NO_NT)
+          continue;
+
+        // The hint narrows the position of the key down to an interval of the old bucket, scaled to the new table.
+        // If that interval spans more than one new bucket, the entry is stored in all of them.
+        const auto old_hint = (hints >> (j * HintBits)) & ((1u << HintBits) - 1);
+        const auto scale    = static_cast<double>(bucket_count_) / static_cast<double>(from_count);
+        const auto lo       = (static_cast<double>(i) + static_cast<double>(old_hint) / (1u << HintBits)) * scale;
+        const auto hi       = (static_cast<double>(i) + static_cast<double>(old_hint + 1) / (1u << HintBits)) * scale;
+        const auto first    = std::min(static_cast<std::size_t>(lo), bucket_count_ - 1);
+        const auto last     = std::min(static_cast<std::size_t>(std::ceil(hi)) - 1, bucket_count_ - 1);
+        const auto k16      = e.key16();
+
+        for (auto index = first; index <= std::max(first, last); ++index)
+        {
+          const auto offset   = static_cast<double>(index);
+          const auto middle   = (std::max(lo, offset) + std::min(hi, offset + 1.0)) / 2.0;
+          const auto new_hint = static_cast<std::uint32_t>((middle - offset) * (1u << HintBits));
+
+          auto *bucket = &table_[index];
+          auto *target = replacement_slot(bucket, k16);
+
+          // Several old buckets can map to the same new bucket, keep the deepest and most recent entries
+          if (const auto current = target->load();
+              current.flags() != NO_NT && current.key16() != k16 && replacement_score(current) >= replacement_score(e))
+            continue;
+
+          target->save(k16, e.generation(), e.depth(), e.flags(), e.move(), e.score(), e.eval());
+          set_hint(bucket, static_cast<std::size_t>(std::distance(bucket->entry.data(), target)), new_hint);
+        }
+      }
+    }
   });
-  return found != bucket->entry.end() ? found : nullptr;
 }
 
-HashEntry *HashTable::insert(
+bool HashTable::save_file(const std::string &path)
+{
+  wait_for_clear();
+
+  const HashFileHeader header{
+    .magic        = HashFileMagic,
+    .version      = HashFileVersion,
+    .entry_size   = sizeof(HashEntry),
+    .bucket_size  = BucketSize,
+    .bucket_count = bucket_count_,
+    .age          = age_.load(std::memory_order_relaxed)};
+
+  std::array<char, HashFileHeaderSize> page{};
+  std::memcpy(page.data(), &header, sizeof header);
+
+  std::ofstream f(path, std::ios::binary | std::ios::trunc);
+  f.write(page.data(), page.size());
+  f.write(reinterpret_cast<const char *>(table_), static_cast<std::streamsize>(bucket_count_ * sizeof(Bucket)));
+
+  if (!f)
+  {
+    fmt::print("info string Failed to save hash to {}\n", path);
+    return false;
+  }
+
+  fmt::print("info string Saved {}MB hash to {}\n", size_mb_, path);
+  return true;
+}
+
+bool HashTable::load_file(const std::string &path)
+{
+  wait_for_clear();
+
+  std::ifstream f(path, std::ios::binary);
+  HashFileHeader header{};
+
+  if (!f.read(reinterpret_cast<char *>(&header), sizeof header))
+  {
+    fmt::print("info string Unable to read hash file {}\n", path);
+    return false;
+  }
+
+  if (
+    header.magic != HashFileMagic || header.version != HashFileVersion || header.entry_size != sizeof(HashEntry)
+    || header.bucket_size != BucketSize)
+  {
+    fmt::print("info string {} is not a compatible hash file\n", path);
+    return false;
+  }
+
+  const auto bytes = header.bucket_count * sizeof(Bucket);
+  auto block       = memory::map_file(path, HashFileHeaderSize + bytes);
+
+  if (!block.ptr)
+  {
+    // No memory mapping available, read the buckets into memory
+    block = memory::alloc_large(HashFileHeaderSize + bytes);
+    f.seekg(HashFileHeaderSize);
+
+    if (!block.ptr || !f.read(static_cast<char *>(block.ptr) + HashFileHeaderSize, static_cast<std::streamsize>(bytes)))
+    {
+      memory::free_large(block);
+      fmt::print("info string Unable to read hash file {}\n", path);
+      return false;
+    }
+  }
+
+  auto *const file_table = reinterpret_cast<Bucket *>(static_cast<char *>(block.ptr) + HashFileHeaderSize);
+
+  if (header.bucket_count == bucket_count_)
+  {
+    // Same size, the file is used as the table as is
+    memory::free_large(mem_);
+    mem_   = block;
+    table_ = file_table;
+
+    // the file was saved with no clear running, so all buckets carry the same mark
+    clear_mark_ = table_[0].hints & ClearMarkBit;
+
+#if defined(TT_STATS)
+    std::ranges::fill(keys_, 0);
+#endif
+  } else
+  {
+    clear();
+    rehash(file_table, header.bucket_count);
+    memory::free_large(block);
+
+    fmt::print("info string Rehashed {}MB hash file into the {}MB table\n", bytes / (1024 * 1024), size_mb_);
+  }
+
+  age_.store(header.age, std::memory_order_relaxed);
+
+  fmt::print("info string Loaded {}MB hash from {}\n", size_mb_, path);
+  return true;
+}
+
+std::optional<HashEntry> HashTable::find(const Key key) const
+{
+  const auto k16 = key16(key);
+
+#if defined(TT_STATS)
+  stats_.probes.fetch_add(1, std::memory_order_relaxed);
+#endif
+
+  auto *const bucket = find_bucket(key);
+
+  // the entries of a bucket not yet zeroed by a background clear are all from before the clear
+  if (is_pending(bucket))
+    return std::nullopt;
+
+  for (auto &e : bucket->entry)
+  {
+    // work on a snapshot, the slot itself can be overwritten by other threads at any time
+    if (const auto entry = e.load(); entry.key16() == k16 && entry.flags())
+    {
+#if defined(TT_STATS)
+      stats_.hits.fetch_add(1, std::memory_order_relaxed);
+
+      const auto index = static_cast<std::size_t>(bucket - table_) * BucketSize + static_cast<std::size_t>(&e - bucket->entry.data());
+
+      if (const auto full_key = std::atomic_ref(keys_[index]).load(std::memory_order_relaxed); full_key && full_key != key)
+        stats_.collisions.fetch_add(1, std::memory_order_relaxed);
+#endif
+
+      return std::make_optional(entry);
+    }
+  }
+
+  return std::nullopt;
+}
+
+void HashTable::insert(
   const Key key,
   const int depth,
   const int score,
@@ -112,75 +409,89 @@ HashEntry *HashTable::insert(
   const Move m,
   const int eval)
 {
-  auto *transp = get_entry_to_replace(key, depth);
+  auto *bucket = find_bucket(key);
 
-  if (transp->f == NO_NT)
-    occupied_++;
-
-  const auto k32 = key32(key);
-
-  if (transp->k != k32 || m != MOVE_NONE)
-    transp->m = m;
+  // zero the bucket here if the background clear has not reached it, the entry is dropped
+  // if another thread is zeroing it right now
+  if (!zero_bucket(bucket))
+    return;
 
-  transp->k = k32;
-  transp->s = static_cast<std::int16_t>(score);
-  transp->d = static_cast<std::uint8_t>(depth);
-  transp->f = nt;
-  transp->a = static_cast<std::uint16_t>(age_);
-  transp->e = static_cast<std::int16_t>(eval);
-  return transp;
+  const auto k16 = key16(key);
+  auto *transp   = replacement_slot(bucket, k16);
+  const auto old = transp->load();
+
+  // keep the move already stored for this position if no new move is known
+  const auto move = old.key16() != k16 || m != MOVE_NONE ? m : old.move();
+  const auto slot = static_cast<std::size_t>(std::distance(bucket->entry.data(), transp));
+
+#if defined(TT_STATS)
+  const auto reason = [&] {
+    if (old.flags() == NO_NT)
+      return REPLACED_EMPTY;
+    if (old.key16() == k16)
+      return REPLACED_SAME_KEY;
+    if (old.generation() != generation())
+      return REPLACED_AGED;
+    return old.depth() > depth ? REPLACED_DEEPER : REPLACED_SHALLOWER;
+  }();
+
+  stats_.replaced[reason].fetch_add(1, std::memory_order_relaxed);
+  std::atomic_ref(keys_[static_cast<std::size_t>(bucket - table_) * BucketSize + slot]).store(key, std::memory_order_relaxed);
+#endif
+
+  transp->save(k16, generation(), depth, nt, move, score, eval);
+  set_hint(bucket, slot, hint(key, bucket_count_));
 }
 
-void HashTable::insert(const PVEntry &pv)
+int HashTable::load() const
 {
-  auto *transp = get_entry_to_replace(pv.key, pv.depth);
+  constexpr std::size_t sample_entries = 1000;
 
-  if (transp->f == NO_NT)
-    occupied_++;
+  const auto buckets    = std::min(bucket_count_, sample_entries / BucketSize);
+  const auto generation = this->generation();
 
-  const auto k32 = key32(pv.key);
+  std::size_t used{};
 
-  if (transp->k != k32 || pv.move != MOVE_NONE)
-    transp->m = pv.move;
+  for (std::size_t i = 0; i < buckets; ++i)
+    if (!is_pending(&table_[i]))
+      used += std::ranges::count_if(table_[i].entry, [generation](HashEntry &slot) {
+      const auto e = slot.load();
+      return e.flags() != NO_NT && e.generation() == generation;
+    });
 
-  transp->k = k32;
-  transp->s = static_cast<std::int16_t>(pv.score);
-  transp->d = static_cast<std::uint8_t>(pv.depth);
-  transp->f = pv.node_type;
-  transp->a = static_cast<std::uint16_t>(age_);
-  transp->e = static_cast<std::int16_t>(pv.eval);
+  return buckets ? static_cast<int>(used * 1000 / (buckets * BucketSize)) : 0;
 }
 
-HashEntry *HashTable::get_entry_to_replace(
-  const Key key,
-  [[maybe_unused]] const int depth) const
+void HashTable::insert(const PVEntry &pv)
 {
-  auto *bucket   = find_bucket(key);
-  const auto k32 = key32(key);
+  insert(pv.key, pv.depth, pv.score, pv.node_type, pv.move, pv.eval);
+}
 
+HashEntry *HashTable::replacement_slot(Bucket *bucket, const std::uint16_t k16) const
+{
   auto *entry = &bucket->entry.front();
 
-  if (entry->f == NO_NT || entry->k == k32)
+  auto match = [&k16](const HashEntry &e) {
+    return e.flags() == NO_NT || e.key16() == k16;
+  };
+
+  if (match(entry->load()))
     return entry;
 
-  constexpr auto replacement_score = [](const HashEntry *e) {
-    return (e->a << 9) + e->d;
-  };
-  auto match = [&k32](const HashEntry *e) {
-    return e->f == NO_NT || e->k == k32;
-  };
   auto *replace      = entry;
-  auto replace_score = replacement_score(replace);
+  auto replace_score = replacement_score(entry->load());
 
   // Returns true if match is found, otherwise it updates the potential replacer entry
-  const auto replacer = [&](HashEntry &e) {
-    if (match(&e))
+  const auto replacer = [&](HashEntry &slot) {
+    const auto e = slot.load();
+
+    if (match(e))
       return true;
 
-    if (const auto score = replacement_score(&e); score < replace_score)
+    if (const auto score = replacement_score(e); score < replace_score)
     {
       replace_score = score;
-      replace       = &e;
+      replace       = &slot;
     }
 
     return false;
@@ -192,3 +503,106 @@ HashEntry *HashTable::get_entry_to_replace(
 
   return found != bucket->entry.end() ? found : replace;
 }
+
+int HashTable::replacement_score(const HashEntry &e) const
+{
+  // entries from recent searches are kept first, then the deepest
+  const auto relative_age = (GenerationCycle + generation() - e.generation()) % GenerationCycle;
+  return ((GenerationCycle - 1 - relative_age) << 8) + e.depth();
+}
+
+std::uint8_t HashTable::generation() const
+{
+  return static_cast<std::uint8_t>(age_.load(std::memory_order_relaxed) % GenerationCycle);
+}
+
+void HashTable::set_hint(Bucket *bucket, const std::size_t slot, const std::uint32_t hint)
+{
+  // The clear bits share the word, so concurrent stores to the same bucket must not lose each other
+  auto hints       = std::atomic_ref(bucket->hints);
+  const auto shift = slot * HintBits;
+  const auto mask  = ((1u << HintBits) - 1) << shift;
+  auto h           = hints.load(std::memory_order_relaxed);
+
+  while (!hints.compare_exchange_weak(h, (h & ~mask) | (hint << shift), std::memory_order_relaxed))
+    ;
+}
+
+void HashTable::post_stats([[maybe_unused]] const bool depths) const
+{
+#if defined(TT_STATS)
+
+  const auto percent = [](const std::uint64_t n, const std::uint64_t total) {
+    return total ? static_cast<double>(n) * 100.0 / static_cast<double>(total) : 0.0;
+  };
+
+  const auto probes = stats_.probes.load(std::memory_order_relaxed);
+  const auto hits   = stats_.hits.load(std::memory_order_relaxed);
+
+  fmt::print(
+    "info string Hash probes {} hits {} ({:.1f}%) cutoffs {} ({:.1f}%) collisions {} replaced empty {} same key {} aged {} shallower {} deeper {}\n",
+    probes, hits, percent(hits, probes), stats_.cutoffs.load(std::memory_order_relaxed),
+    percent(stats_.cutoffs.load(std::memory_order_relaxed), probes), stats_.collisions.load(std::memory_order_relaxed),
+    stats_.replaced[REPLACED_EMPTY].load(std::memory_order_relaxed),
+    stats_.replaced[REPLACED_SAME_KEY].load(std::memory_order_relaxed),
+    stats_.replaced[REPLACED_AGED].load(std::memory_order_relaxed),
+    stats_.replaced[REPLACED_SHALLOWER].load(std::memory_order_relaxed),
+    stats_.replaced[REPLACED_DEEPER].load(std::memory_order_relaxed));
+
+  if (!depths)
+    return;
+
+  // Stored depths in groups of four plies, scanning the whole table
+  constexpr std::size_t group_size = 4;
+
+  std::array<std::uint64_t, 256 / group_size> groups{};
+  std::uint64_t used{};
+
+  for (std::size_t i = 0; i < bucket_count_; ++i)
+  {
+    if (is_pending(&table_[i]))
+      continue;
+
+    for (auto &slot : table_[i].entry)
+    {
+      if (const auto e = slot.load(); e.flags() != NO_NT)
+      {
+        ++groups[e.depth() / group_size];
+        ++used;
+      }
+    }
+  }
+
+  fmt::memory_buffer buffer;
+  auto inserter = std::back_inserter(buffer);
+
+  fmt::format_to(inserter, "info string Hash entries {} of {}, depths", used, bucket_count_ * BucketSize);
+
+  for (std::size_t i = 0; i < groups.size(); ++i)
+    if (groups[i])
+      fmt::format_to(inserter, " {}-{}: {}", i * group_size, i * group_size + group_size - 1, groups[i]);
+
+  fmt::print("{}\n", fmt::to_string(buffer));
+
+#else
+
+  if (depths)
+    fmt::print("info string Hash statistics are not available, build with TT_STATS enabled\n");
+
+#endif
+}
+
+#if defined(TT_STATS)
+
+void HashTable::reset_stats()
+{
+  stats_.probes     = 0;
+  stats_.hits       = 0;
+  stats_.cutoffs    = 0;
+  stats_.collisions = 0;
+
+  for (auto &r : stats_.replaced)
+    r = 0;
+}
+
+#endif
@@ -20,90 +20,141 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <atomic>
+#include <bit>
+#include <optional>
+#include <string>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include "types.hpp"
 #include "miscellaneous.hpp"
 
 struct PVEntry;
 
-#pragma pack(1)
-struct alignas(CacheLineSize / 4) HashEntry final
+namespace numa
+{
+struct Placement;
+}
+
+/// A transposition table entry is 12 bytes, stored as three 32 bit words which every search thread reads and writes
+/// without locking. The first word holds the lower 16 bits of the key, the depth, the flags and the generation, and is
+/// stored xor'ed with the folded move and value words. A probe that reads the words from different writes will fail
+/// the key verification and is treated as a miss instead of returning a torn entry.
+struct alignas(4) HashEntry final
 {
   [[nodiscard]]
   bool is_exact() const noexcept
   {
-    return f & EXACT;
+    return flags() & EXACT;
   }
 
   [[nodiscard]]
   bool is_beta() const noexcept
   {
-    return f & BETA;
+    return flags() & BETA;
   }
 
   [[nodiscard]]
   bool is_alpha() const noexcept
   {
-    return f & ALPHA;
+    return flags() & ALPHA;
   }
 
   [[nodiscard]]
   std::uint8_t depth() const noexcept
   {
-    return d;
+    return static_cast<std::uint8_t>(meta() >> 16);
   }
 
   [[nodiscard]]
   NodeType flags() const noexcept
   {
-    return static_cast<NodeType>(f & 7);
+    return static_cast<NodeType>((meta() >> 24) & 7);
   }
 
   [[nodiscard]]
   std::int16_t score() const noexcept
   {
-    return s;
+    return static_cast<std::int16_t>(value_);
   }
 
   [[nodiscard]]
   std::int16_t eval() const noexcept
   {
-    return e;
+    return static_cast<std::int16_t>(value_ >> 16);
   }
 
   [[nodiscard]]
   Move move() const noexcept
   {
-    return m;
+    return static_cast<Move>(move_);
   }
 
 private:
-  std::uint32_t k;   // key
-  std::uint16_t a;   // age, 7 bits left
-  std::uint8_t d;    // depth
-  NodeType f;   // flags, 5 bits left
-  std::int16_t s;    // score
-  Move m;       // move
-  std::int16_t e;    // eval
-
-  friend class HashTable;
+  [[nodiscard]]
+  static constexpr std::uint32_t fold(const std::uint32_t move, const std::uint32_t value) noexcept
+  {
+    const auto x = move ^ value;
+    return x ^ std::rotl(x, 16);
+  }
+
+  [[nodiscard]]
+  std::uint32_t meta() const noexcept
+  {
+    return key_ ^ fold(move_, value_);
+  }
+
+  [[nodiscard]]
+  std::uint16_t key16() const noexcept
+  {
+    return static_cast<std::uint16_t>(meta());
+  }
+
+  [[nodiscard]]
+  std::uint8_t generation() const noexcept
+  {
+    return static_cast<std::uint8_t>(meta() >> 27);
+  }
+
+  /// Reads the words atomically (each on its own), the returned copy is a private snapshot
+  [[nodiscard]]
+  HashEntry load() noexcept;
+
+  void save(std::uint16_t k16, std::uint8_t generation, int depth, NodeType nt, Move m, int score, int eval) noexcept;
+
+  void reset() noexcept;
+
+  std::uint32_t key_;     // key16 | depth << 16 | flags << 24 | generation << 27, xor'ed with fold(move_, value_)
+  std::uint32_t move_;
+  std::uint32_t value_;   // score | eval << 16
+
+  friend struct HashTable;
 };
-#pragma pack()
 
 struct HashTable final
 {
 private:
   friend struct HashEntry;
 
-  static constexpr std::size_t BucketSize = 4;
+  static constexpr std::size_t BucketSize = 5;
+
+  // Generations are stored in 5 bits and wrap around
+  static constexpr int GenerationCycle = 32;
 
   using BucketArray = std::array<HashEntry, BucketSize>;
 
-  // Just use a simple array for bucket
+  /// A bucket fills one cache line. The remaining 4 bytes hold 6 bits per entry of
+  /// where the key falls inside the bucket, which lets a resize place the entry in
+  /// the right bucket of the new table although only 16 bits of the key are kept.
+  /// The two top bits track the background clear of the bucket.
   struct Bucket final
   {
     alignas(CacheLineSize) BucketArray entry{};
+    std::uint32_t hints{};
   };
 
 public:
@@ -114,17 +165,37 @@ public:
   HashTable &operator=(const HashTable &) = delete;
   HashTable &operator=(HashTable &&other) = delete;
 
-  void init(std::uint64_t new_size_mb);
+  /// init() resizes the table and keeps its entries, returns false if the table already had the size
+  bool init(std::uint64_t new_size_mb);
+
+  /// page_info() describes the memory of the table, it is printed with the UCI output when the table is resized
+  [[nodiscard]]
+  std::string page_info() const;
+
+  /// set_thread_count() sets how many threads share the work when the table is cleared or resized,
+  /// each of them is pinned like the search thread of the same index
+  void set_thread_count(const std::size_t count, const numa::Placement *placement) noexcept
+  {
+    thread_count_ = std::max<std::size_t>(count, 1);
+    placement_    = placement;
+  }
 
   void clear();
 
+  /// clear_async() starts a new generation and zeroes the table in a background thread, a bucket
+  /// it has not reached yet is treated as empty by find() and zeroed first by insert()
+  void clear_async();
+
+  /// wait_for_clear() blocks until a background clear has finished
+  void wait_for_clear();
+
   void init_search();
 
-  [[nodiscard]]
-  HashEntry *first_entry(const Key key) const
-  {
-    return &table_[mul_hi64(key, bucket_count_)].entry[0];
-  }
+  /// record_cutoff() counts a probe whose score could be used for a cutoff, only when built with TT_STATS
+  void record_cutoff() const;
+
+  /// post_stats() prints the counters of the last search and the depths of the stored entries
+  void post_stats(bool depths) const;
 
   [[nodiscard]]
   Bucket *find_bucket(const Key key) const
@@ -133,15 +204,21 @@ public:
   }
 
   [[nodiscard]]
-  HashEntry *find(Key key) const;
+  std::optional<HashEntry> find(Key key) const;
 
-  HashEntry *insert(Key key, int depth, int score, NodeType nt, Move m, int eval);
+  void insert(Key key, int depth, int score, NodeType nt, Move m, int eval);
 
   void insert(const PVEntry &pv);
 
-  [[nodiscard]]
-  HashEntry *get_entry_to_replace(Key key, [[maybe_unused]] int depth) const;
+  /// save_file() writes the table with a small header to a file, so a restarted engine can start with a warm table.
+  /// load_file() uses a file of the current size as the table, mapped when possible and read into memory otherwise.
+  /// A file of another size is rehashed into a newly allocated table of the current size.
+  bool save_file(const std::string &path);
+
+  bool load_file(const std::string &path);
 
+  /// load() returns the permille of a fixed sample of entries written in the
+  /// current search, as reported by hashfull
   [[nodiscard]]
   int load() const;
 
@@ -149,32 +226,132 @@ public:
   int size_mb() const;
 
 private:
-  static_assert(CacheLineSize % sizeof(Bucket) == 0, "Bucket size incorrect");
+  [[nodiscard]]
+  HashEntry *replacement_slot(Bucket *bucket, std::uint16_t k16) const;
+
+  [[nodiscard]]
+  int replacement_score(const HashEntry &e) const;
+
+  [[nodiscard]]
+  std::uint8_t generation() const;
+
+  static void set_hint(Bucket *bucket, std::size_t slot, std::uint32_t hint);
+
+  /// is_pending() returns true if the bucket still holds entries from before the last clear_async()
+  [[nodiscard]]
+  bool is_pending(Bucket *bucket) const;
+
+  /// zero_bucket() zeroes a pending bucket, it returns false if another thread is zeroing it
+  bool zero_bucket(Bucket *bucket) const;
+
+  /// rehash() moves the entries of another table into this one, keeping the
+  /// deepest and most recent entries where they collide
+  void rehash(Bucket *from, std::size_t from_count);
+
+  static_assert(sizeof(HashEntry) == 12, "Entry size incorrect");
+  static_assert(sizeof(Bucket) == CacheLineSize, "Bucket size incorrect");
 
   Bucket *table_{};
-  void *mem_{};
+  memory::LargeBlock mem_{};
 
   std::size_t bucket_count_{};
-  std::size_t fullness_element_{};
-  std::uint64_t occupied_{};
   std::uint64_t size_mb_{};
-  std::uint64_t size_{};
-  int age_{};
+  std::size_t thread_count_{1};
+  const numa::Placement *placement_{};
+  // read by the background clear while a search can start a new generation
+  std::atomic_int age_{};
+
+  // the clear bit of a bucket zeroed since the last clear_async()
+  std::uint32_t clear_mark_{};
+  std::unique_ptr<std::jthread> clearer_{};
+
+#if defined(TT_STATS)
+
+  enum Replacement
+  {
+    REPLACED_EMPTY,
+    REPLACED_SAME_KEY,
+    REPLACED_AGED,
+    REPLACED_SHALLOWER,
+    REPLACED_DEEPER,
+    REPLACED_NB
+  };
+
+  /// Counters of the current search, shared by all threads. They are only meant for
+  /// sizing decisions, so the contention on them is accepted in TT_STATS builds.
+  struct Stats final
+  {
+    std::atomic_uint64_t probes{};
+    std::atomic_uint64_t hits{};
+    std::atomic_uint64_t cutoffs{};
+    std::atomic_uint64_t collisions{};
+    std::array<std::atomic_uint64_t, REPLACED_NB> replaced{};
+  };
+
+  void reset_stats();
+
+  mutable Stats stats_{};
+
+  // The full key of each entry, a hit with a different full key is a collision. Zero if not known.
+  // Every search thread reads and writes them, so they are only accessed through atomic_ref.
+  mutable std::vector<Key> keys_{};
+
+#endif
 };
 
+inline HashEntry HashEntry::load() noexcept
+{
+  HashEntry e;
+  e.key_   = std::atomic_ref(key_).load(std::memory_order_relaxed);
+  e.move_  = std::atomic_ref(move_).load(std::memory_order_relaxed);
+  e.value_ = std::atomic_ref(value_).load(std::memory_order_relaxed);
+  return e;
+}
+
+inline void HashEntry::save(
+  const std::uint16_t k16,
+  const std::uint8_t generation,
+  const int depth,
+  const NodeType nt,
+  const Move m,
+  const int score,
+  const int eval) noexcept
+{
+  const auto meta = static_cast<std::uint32_t>(k16) | static_cast<std::uint32_t>(static_cast<std::uint8_t>(depth)) << 16
+                    | static_cast<std::uint32_t>(nt) << 24 | static_cast<std::uint32_t>(generation) << 27;
+  const auto move  = static_cast<std::uint32_t>(m);
+  const auto value = static_cast<std::uint32_t>(static_cast<std::uint16_t>(score))
+                     | static_cast<std::uint32_t>(static_cast<std::uint16_t>(eval)) << 16;
+
+  std::atomic_ref(move_).store(move, std::memory_order_relaxed);
+  std::atomic_ref(value_).store(value, std::memory_order_relaxed);
+  std::atomic_ref(key_).store(meta ^ fold(move, value), std::memory_order_relaxed);
+}
+
+inline void HashEntry::reset() noexcept
+{
+  std::atomic_ref(key_).store(0, std::memory_order_relaxed);
+  std::atomic_ref(move_).store(0, std::memory_order_relaxed);
+  std::atomic_ref(value_).store(0, std::memory_order_relaxed);
+}
+
 inline void HashTable::init_search()
 {
   age_++;
+
+#if defined(TT_STATS)
+  reset_stats();
+#endif
 }
 
-inline int HashTable::load() const
+inline void HashTable::record_cutoff() const
 {
-  return static_cast<int>(static_cast<double>(occupied_) / fullness_element_ * 1000);
+#if defined(TT_STATS)
+  stats_.cutoffs.fetch_add(1, std::memory_order_relaxed);
+#endif
 }
 
 inline int HashTable::size_mb() const
 {
   return static_cast<int>(size_mb_);
 }
-
-constinit inline HashTable TT;
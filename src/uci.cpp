@@ -19,15 +19,18 @@
 */
 
 #include <sstream>
+#include <string>
+#include <vector>
 #include <cstdio>
 
 #include "uci.hpp"
 #include "board.hpp"
-#include "transpositional.hpp"
+#include "engine.hpp"
 #include "perft.hpp"
 #include "moves.hpp"
 #include "eval.hpp"
 #include "polyglot.hpp"
+#include "stopwatch.hpp"
 namespace
 {
 
@@ -36,10 +39,11 @@ constexpr TimeUnit time_safety_margin = 1;
 [[nodiscard]]
 std::unique_ptr<Board> new_board()
 {
-  const auto num_threads = static_cast<std::size_t>(Options[uci::uci_name<uci::UciOptions::THREADS>()]);
-  pool.set(num_threads);
+  auto &e = uci::engine();
+  e.configure(uci::config());
+  e.pool.clear_data();
   auto board = std::make_unique<Board>();
-  board->set_fen(start_position, pool.main());
+  board->set_fen(start_position, e.pool.main());
   return board;
 }
 
@@ -49,13 +53,6 @@ constexpr std::uint64_t nps(const std::uint64_t nodes, const TimeUnit time)
   return nodes * 1000 / time;
 }
 
-[[nodiscard]]
-auto node_info(const TimeUnit time)
-{
-  const auto nodes = pool.node_count();
-  return std::make_pair(nodes, nps(nodes, time));
-}
-
 [[nodiscard]]
 Move string_to_move(Board *b, const std::string_view m)
 {
@@ -69,34 +66,52 @@ Move string_to_move(Board *b, const std::string_view m)
   return MOVE_NONE;
 }
 
+/// book_best_move() reads the option, which only exists when there are book files
+[[nodiscard]]
+bool book_best_move()
+{
+  return Options.contains(uci::uci_name<uci::UciOptions::BOOK_BEST_MOVE>())
+         && Options[uci::uci_name<uci::UciOptions::BOOK_BEST_MOVE>()];
+}
+
 void position(Board *b, std::istringstream &input)
 {
   std::string token;
+  std::string fen;
 
   input >> token;
 
   [[likely]]
   if (token == "startpos")
   {
-    b->new_game(pool.main());
+    fen = start_position;
 
     // get rid of "moves" token
     input >> token;
   }
   else if (token == "fen")
   {
-    fmt::memory_buffer fen;
-    auto inserter = std::back_inserter(fen);
+    fmt::memory_buffer fen_buffer;
+    auto inserter = std::back_inserter(fen_buffer);
     while (input >> token && token != "moves")
       fmt::format_to(inserter, "{} ", token);
-    b->set_fen(fmt::to_string(fen), pool.main());
+    fen = fmt::to_string(fen_buffer);
   }
   else return;
 
-  // parse any moves if they exist
+  std::vector<std::string> moves;
+
   while (input >> token)
+    moves.emplace_back(std::move(token));
+
+  // the position stack only holds the moves of the game and the search, so it has to fit them before the setup
+  b->set_game_length(moves.size());
+  b->set_fen(fen, uci::engine().pool.main());
+
+  // parse any moves if they exist
+  for (const auto &m_str : moves)
     [[likely]]
-    if (const auto m = string_to_move(b, token); m)
+    if (const auto m = string_to_move(b, m_str); m)
       b->make_move(m, false, true);
 }
 
@@ -127,12 +142,9 @@ void set_option(std::istringstream &input)
   fmt::print("{}", uci_info);
 }
 
-void go(std::istringstream &input, std::string_view fen)
+void go(Board *b, std::istringstream &input)
 {
-  auto &limits = pool.limits;
-
-  limits.clear();
-
+  SearchLimits limits;
   std::string token;
 
   while (input >> token)
@@ -147,15 +159,129 @@ void go(std::istringstream &input, std::string_view fen)
     else if (token == "movestogo")
       input >> limits.movestogo;
     else if (token == "depth")
+    {
       input >> limits.depth;
+      limits.fixed_depth = true;
+    }
+    else if (token == "nodes")
+      input >> limits.nodes;
+    else if (token == "mate")
+      input >> limits.mate;
     else if (token == "movetime")
+    {
       input >> limits.movetime;
+      limits.fixed_movetime = true;
+    }
     else if (token == "infinite")
       limits.infinite = true;
     else if (token == "ponder")
       limits.ponder = true;
+    else if (token == "searchmoves")
+    {
+      // the moves run to the end of the command
+      while (input >> token)
+        if (const auto m = string_to_move(b, token); m)
+          limits.search_moves.emplace_back(m);
+    }
+
+  auto &e = uci::engine();
+  e.configure(uci::config());
+  e.start(b->fen(), limits);
+}
+
+constexpr std::array<std::string_view, 8> bench_positions{
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 38",
+  "r1bq1rk1/pp2bppp/2n2n2/3p4/3P4/2NBPN2/PP3PPP/R2QK2R w KQ - 2 9",
+  "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+  "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+  "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+  "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1"};
+
+/// run_bench() searches the bench positions to a fixed depth from empty tables
+/// and returns the total node count and the time used
 
-  pool.start_thinking(fen);
+std::pair<std::uint64_t, TimeUnit> run_bench(const int depth)
+{
+  auto &e = uci::engine();
+
+  e.tt.clear();
+  e.pool.clear_data();
+
+  SearchLimits limits;
+  limits.depth       = depth;
+  limits.fixed_depth = true;
+
+  std::uint64_t nodes{};
+  Stopwatch sw;
+
+  for (const auto fen : bench_positions)
+  {
+    e.search(fen, limits);
+    nodes += e.pool.node_count();
+  }
+
+  return {nodes, std::max<TimeUnit>(sw.elapsed_milliseconds(), 1)};
+}
+
+/// bench() searches a fixed set of positions to a fixed depth and reports the
+/// total node count and speed. The node count acts as a signature of the search.
+
+void bench(std::istringstream &input)
+{
+  auto depth = 12;
+
+  if (std::string token; input >> token)
+    depth = std::max(1, util::to_integral<int>(token));
+
+  const auto [nodes, time] = run_bench(depth);
+
+  fmt::print(stderr, "\nPositions       : {}\nDepth           : {}\n", bench_positions.size(), depth);
+  fmt::print(stderr, "Nodes searched  : {}\nTime (ms)       : {}\nNodes/second    : {}\n", nodes, time, nps(nodes, time));
+}
+
+/// smpbench() runs the bench with 1 up to the given number of threads and reports the
+/// time to depth speedup over a single thread, used to validate the helper thread scheduling.
+/// The hash size is kept the same for all thread counts.
+
+void smpbench(std::istringstream &input)
+{
+  auto depth   = 12;
+  auto threads = static_cast<int>(std::thread::hardware_concurrency());
+
+  if (std::string token; input >> token)
+    depth = std::max(1, util::to_integral<int>(token));
+
+  if (std::string token; input >> token)
+    threads = std::max(1, util::to_integral<int>(token));
+
+  auto &e       = uci::engine();
+  auto config   = uci::config();
+
+  // the hash size is kept the same for all thread counts
+  config.hash_x_threads = false;
+
+  fmt::print(stderr, "\nDepth           : {}\n", depth);
+
+  TimeUnit single_thread_time{};
+
+  for (auto n = 1; n <= threads; ++n)
+  {
+    config.threads = static_cast<std::size_t>(n);
+    e.configure(config);
+
+    const auto [nodes, time] = run_bench(depth);
+
+    if (n == 1)
+      single_thread_time = time;
+
+    fmt::print(
+      stderr, "Threads {:>3}     : time {} ms, nodes {}, nps {}, speedup {:.2f}\n", n, time, nodes, nps(nodes, time),
+      static_cast<double>(single_thread_time) / static_cast<double>(time));
+  }
+
+  e.configure(uci::config());
 }
 
 }   // namespace
@@ -174,46 +300,118 @@ void uci::post_moves(const Move m, const Move ponder_move)
   fmt::print("{}\n", fmt::to_string(buffer));
 }
 
-void uci::post_info(const int d, const int selective_depth)
+void uci::format_info(
+  fmt::memory_buffer &buffer, const thread_pool &pool, const std::uint64_t nodes, const TimeUnit elapsed, const int d,
+  const int selective_depth)
 {
-  const auto time                           = pool.main()->time.elapsed() + time_safety_margin;
-  const auto [node_count, nodes_per_second] = node_info(time);
-  if (!Options[uci_name<UciOptions::SHOW_CPU>()])
-    fmt::print(
-      "info depth {} seldepth {} hashfull {} nodes {} nps {} time {}\n", d, selective_depth, TT.load(), node_count,
-      nodes_per_second, time);
+  auto inserter   = std::back_inserter(buffer);
+  const auto time = elapsed + time_safety_margin;
+  if (!pool.config.show_cpu)
+    fmt::format_to(
+      inserter, "info depth {} seldepth {} hashfull {} nodes {} nps {} time {}\n", d, selective_depth,
+      pool.tt.load(), nodes, nps(nodes, time), time);
   else
+    fmt::format_to(
+      inserter, "info depth {} seldepth {} hashfull {} nodes {} nps {} time {} cpuload {}\n", d, selective_depth,
+      pool.tt.load(), nodes, nps(nodes, time), time, Cpu.usage());
+}
+
+void uci::post_eval_cache_info(const thread_pool &pool)
+{
+  std::uint64_t probes{};
+  std::uint64_t hits{};
+
+  for (const auto &t : pool)
+  {
+    probes += t->eval_cache.probes;
+    hits += t->eval_cache.hits;
+  }
+
+  if (probes)
     fmt::print(
-      "info depth {} seldepth {} hashfull {} nodes {} nps {} time {} cpuload {}\n", d, selective_depth, TT.load(),
-      node_count, nodes_per_second, time, Cpu.usage());
+      "info string Eval cache {}MB per thread, hit rate {:.1f}%\n", pool.main()->eval_cache.size_mb(),
+      static_cast<double>(hits) * 100.0 / static_cast<double>(probes));
 }
 
-void uci::post_curr_move(const Move m, const int m_number)
+void uci::post_memory_info(const thread_pool &pool)
 {
-  fmt::print("info currmove {} currmovenumber {}\n", display_uci(m), m_number);
+  constexpr std::size_t KB = 1024;
+
+  std::size_t total{};
+
+  for (const auto &t : pool)
+  {
+    const auto board = t->root_board->bytes();
+    const auto bytes = sizeof(thread) + board + t->pawn_hash.bytes() + t->eval_cache.bytes();
+
+    fmt::print(
+      "info string Thread {} uses {}kB: thread {}kB, board {}kB, pawn hash {}kB, eval cache {}kB\n", t->index(),
+      bytes / KB, sizeof(thread) / KB, board / KB, t->pawn_hash.bytes() / KB, t->eval_cache.bytes() / KB);
+
+    total += bytes;
+  }
+
+  fmt::print("info string {} threads use {}kB, hash table {}MB\n", pool.size(), total / KB, pool.tt.size_mb());
 }
 
-void uci::post_pv(const int d, const int max_ply, const int score, const std::span<PVEntry> &pv_line, const NodeType nt)
+void uci::format_curr_move(fmt::memory_buffer &buffer, const Move m, const int m_number)
+{
+  fmt::format_to(std::back_inserter(buffer), "info currmove {} currmovenumber {}\n", display_uci(m), m_number);
+}
+
+void uci::format_pv(
+  fmt::memory_buffer &buffer, const thread_pool &pool, const std::uint64_t nodes, const TimeUnit elapsed, const int d,
+  const int max_ply, const int score, const std::span<const Move> pv_line, const NodeType nt, const int multi_pv)
 {
-  fmt::memory_buffer buffer;
   auto inserter = std::back_inserter(buffer);
 
-  fmt::format_to(inserter, "info depth {} seldepth {} score cp {} ", d, max_ply, score);
+  fmt::format_to(inserter, "info depth {} seldepth {} ", d, max_ply);
+
+  if (multi_pv > 0)
+    fmt::format_to(inserter, "multipv {} ", multi_pv);
+
+  fmt::format_to(inserter, "score cp {} ", score);
 
   if (nt == ALPHA)
     fmt::format_to(inserter, "upperbound ");
   else if (nt == BETA)
     fmt::format_to(inserter, "lowerbound ");
 
-  const auto time                           = pool.main()->time.elapsed() + time_safety_margin;
-  const auto [node_count, nodes_per_second] = node_info(time);
+  const auto time = elapsed + time_safety_margin;
 
-  fmt::format_to(inserter, "hashfull {} nodes {} nps {} time {} pv ", TT.load(), node_count, nodes_per_second, time);
+  fmt::format_to(inserter, "hashfull {} nodes {} nps {} time {} pv ", pool.tt.load(), nodes, nps(nodes, time), time);
 
-  for (auto &pv : pv_line)
-    fmt::format_to(inserter, "{} ", pv.move);
+  for (const auto m : pv_line)
+    fmt::format_to(inserter, "{} ", m);
 
-  fmt::print("{}\n", fmt::to_string(buffer));
+  fmt::format_to(inserter, "\n");
+}
+
+Engine &uci::engine()
+{
+  static Engine instance(config());
+  return instance;
+}
+
+EngineConfig uci::config()
+{
+  EngineConfig s;
+
+  s.threads        = static_cast<std::size_t>(Options[uci_name<UciOptions::THREADS>()]);
+  s.hash_mb        = static_cast<std::size_t>(Options[uci_name<UciOptions::HASH>()]);
+  s.hash_x_threads = Options[uci_name<UciOptions::HASH_X_THREADS>()];
+  s.eval_cache_mb  = static_cast<std::size_t>(Options[uci_name<UciOptions::EVAL_CACHE>()]);
+  s.pawn_hash_mb   = static_cast<std::size_t>(Options[uci_name<UciOptions::PAWN_HASH>()]);
+  s.thread_binding = std::string_view(Options[uci_name<UciOptions::THREAD_BINDING>()]);
+  s.skip_depths    = Options[uci_name<UciOptions::SMP_SKIP_DEPTHS>()];
+  s.ordering_noise = Options[uci_name<UciOptions::SMP_ORDERING_NOISE>()];
+  s.multi_pv       = static_cast<std::size_t>(Options[uci_name<UciOptions::MULTI_PV>()]);
+  s.use_book       = Options[uci_name<UciOptions::USE_BOOK>()];
+  s.book_best_move = book_best_move();
+  s.show_cpu       = Options[uci_name<UciOptions::SHOW_CPU>()];
+  s.uci_output     = true;
+
+  return s;
 }
 
 std::string uci::display_uci(const Move m)
@@ -257,9 +455,11 @@ void uci::run(const int argc, char *argv[])
 
     [[unlikely]]
     if (token == "quit" || token == "stop")
-      pool.stop = true;
+      engine().stop();
     else if (token == "ponder")
-      pool.main()->ponder = true;
+      engine().pool.main()->set_ponder(true);
+    else if (token == "ponderhit")
+      engine().ponder_hit();
     else if (token == "uci")
       fmt::print("{}{}\nuciok\n", misc::print_engine_info<true>(), Options);
     else if (token == "isready")
@@ -267,7 +467,7 @@ void uci::run(const int argc, char *argv[])
     else if (token == "ucinewgame")
     {
       if (Options[uci::uci_name<UciOptions::CLEAR_HASH_NEW_GAME>()])
-        TT.clear();
+        engine().tt.clear_async();
       board = new_board();
       fmt::print("readyok\n");
     } else if (token == "setoption")
@@ -275,7 +475,15 @@ void uci::run(const int argc, char *argv[])
     else if (token == "position")
       position(board.get(), input);
     else if (token == "go")
-      go(input, board->fen());
+      go(board.get(), input);
+    else if (token == "bench")
+      bench(input);
+    else if (token == "smpbench")
+      smpbench(input);
+    else if (token == "hashstats")
+      engine().tt.post_stats(true);
+    else if (token == "meminfo")
+      uci::post_memory_info(engine().pool);
     else if (token == "perft")
     {
       const auto total = perft::perft(board.get(), 6);
@@ -295,7 +503,7 @@ void uci::run(const int argc, char *argv[])
       fmt::print("Eval: {}\n", e);
     } else if (token == "book")
     {
-      const auto m = book.probe(board.get());
+      const auto m = book.probe(board.get(), book_best_move());
       uci::post_moves(m, MOVE_NONE);
     } else if (token == "exit")
       break;
@@ -33,10 +33,13 @@
 #include "miscellaneous.hpp"
 #include "types.hpp"
 #include "pv_entry.hpp"
+#include "engine_config.hpp"
 #include "search_limits.hpp"
 #include "cpu.hpp"
 
 struct Board;
+struct Engine;
+struct thread_pool;
 
 namespace uci
 {
@@ -46,17 +49,26 @@ inline CpuLoad Cpu;
 enum class UciOptions
 {
   THREADS,
+  THREAD_BINDING,
   HASH,
   HASH_X_THREADS,
   CLEAR_HASH,
   CLEAR_HASH_NEW_GAME,
+  HASH_FILE,
+  SAVE_HASH,
+  LOAD_HASH,
+  EVAL_CACHE,
+  PAWN_HASH,
+  SMP_SKIP_DEPTHS,
+  SMP_ORDERING_NOISE,
   PONDER,
+  MULTI_PV,
   UCI_Chess960,
   SHOW_CPU,
   USE_BOOK,
   BOOKS,
   BOOK_BEST_MOVE,
-  UCI_OPT_NB = 11
+  UCI_OPT_NB = 20
 };
 
 using uci_t = std::underlying_type_t<UciOptions>;
@@ -66,8 +78,13 @@ template<UciOptions Option>
 constexpr std::string_view uci_name()
 {
   constexpr std::array<std::string_view, static_cast<uci_t>(UciOptions::UCI_OPT_NB)> UciStrings{
-    "Threads",      "Hash",           "Hash * Threads", "Clear Hash", "Clear hash on new game", "Ponder",
-    "UCI_Chess960", "Show CPU usage", "Use book",       "Books",      "Best Book Move"};
+    "Threads",            "Thread Binding",    "Hash",
+    "Hash * Threads",     "Clear Hash",        "Clear hash on new game",
+    "Hash File",          "Save Hash to File", "Load Hash from File",
+    "Eval Cache",         "Pawn Hash",         "SMP Skip Depths",
+    "SMP Ordering Noise", "Ponder",            "MultiPV",
+    "UCI_Chess960",       "Show CPU usage",    "Use book",
+    "Books",              "Best Book Move"};
 
   return UciStrings[static_cast<uci_t>(Option)];
 }
@@ -165,11 +182,28 @@ void init(OptionsMap &, std::span<std::string>);
 
 void post_moves(Move m, Move ponder_move);
 
-void post_info(int d, int selective_depth);
+/// The format_* functions append a line of search output to the buffer, the reporter of the pool writes it out
+void format_info(
+  fmt::memory_buffer &buffer, const thread_pool &pool, std::uint64_t nodes, TimeUnit elapsed, int d, int selective_depth);
 
-void post_curr_move(Move m, int m_number);
+void format_curr_move(fmt::memory_buffer &buffer, Move m, int m_number);
 
-void post_pv(int d, int max_ply, int score, const std::span<PVEntry> &pv_line, NodeType nt);
+void format_pv(
+  fmt::memory_buffer &buffer, const thread_pool &pool, std::uint64_t nodes, TimeUnit elapsed, int d, int max_ply,
+  int score, std::span<const Move> pv_line, NodeType nt, int multi_pv);
+
+void post_eval_cache_info(const thread_pool &pool);
+
+/// post_memory_info() prints the memory used by each search thread and by the whole pool
+void post_memory_info(const thread_pool &pool);
+
+/// engine() returns the engine instance driven by the UCI commands, created on first use
+[[nodiscard]]
+Engine &engine();
+
+/// config() returns the engine configuration given by the current UCI options
+[[nodiscard]]
+EngineConfig config();
 
 [[nodiscard]]
 std::string display_uci(Move m);
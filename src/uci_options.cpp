@@ -23,8 +23,7 @@
 #include <fmt/format.h>
 
 #include "uci.hpp"
-#include "transpositional.hpp"
-#include "tpool.hpp"
+#include "engine.hpp"
 #include "polyglot.hpp"
 
 using std::string;
@@ -43,12 +42,17 @@ namespace uci
 
 void on_clear_hash(const Option &)
 {
-  TT.clear();
+  engine().tt.clear_async();
 }
 
-void on_hash_size(const Option &o)
+void on_save_hash(const Option &)
 {
-  TT.init(o);
+  engine().tt.save_file(std::string(Options[uci_name<UciOptions::HASH_FILE>()]));
+}
+
+void on_load_hash(const Option &)
+{
+  engine().tt.load_file(std::string(Options[uci_name<UciOptions::HASH_FILE>()]));
 }
 
 void on_book_change(const Option &o)
@@ -58,9 +62,10 @@ void on_book_change(const Option &o)
   book.open(o);
 }
 
-void on_threads(const Option &o)
+/// on_engine_change() hands the options that size the threads and tables to the engine
+void on_engine_change(const Option &)
 {
-  pool.set(o);
+  engine().configure(config());
 }
 
 bool CaseInsensitiveLess::operator()(const std::string_view s1, const std::string_view s2) const noexcept
@@ -72,12 +77,21 @@ bool CaseInsensitiveLess::operator()(const std::string_view s1, const std::strin
 
 void init(OptionsMap &o, std::span<std::string> book_files)
 {
-  o[uci_name<UciOptions::THREADS>()] << Option(1, 1, 512, on_threads);
-  o[uci_name<UciOptions::HASH>()] << Option(256, 1, MaxHashMB, on_hash_size);
+  o[uci_name<UciOptions::THREADS>()] << Option(1, 1, 512, on_engine_change);
+  o[uci_name<UciOptions::THREAD_BINDING>()] << Option("auto", on_engine_change);
+  o[uci_name<UciOptions::HASH>()] << Option(256, 1, MaxHashMB, on_engine_change);
   o[uci_name<UciOptions::HASH_X_THREADS>()] << Option(true);
   o[uci_name<UciOptions::CLEAR_HASH>()] << Option(on_clear_hash);
   o[uci_name<UciOptions::CLEAR_HASH_NEW_GAME>()] << Option(false);
+  o[uci_name<UciOptions::HASH_FILE>()] << Option("feliscatus.hash");
+  o[uci_name<UciOptions::SAVE_HASH>()] << Option(on_save_hash);
+  o[uci_name<UciOptions::LOAD_HASH>()] << Option(on_load_hash);
+  o[uci_name<UciOptions::EVAL_CACHE>()] << Option(1, 0, 1024, on_engine_change);
+  o[uci_name<UciOptions::PAWN_HASH>()] << Option(2, 1, 256, on_engine_change);
+  o[uci_name<UciOptions::SMP_SKIP_DEPTHS>()] << Option(false);
+  o[uci_name<UciOptions::SMP_ORDERING_NOISE>()] << Option(false);
   o[uci_name<UciOptions::PONDER>()] << Option(false);
+  o[uci_name<UciOptions::MULTI_PV>()] << Option(1, 1, static_cast<int>(MaxMultiPv));
   o[uci_name<UciOptions::UCI_Chess960>()] << Option(false);
   o[uci_name<UciOptions::SHOW_CPU>()] << Option(false);
 
@@ -24,16 +24,18 @@
 #include <algorithm>
 
 #include "../src/board.hpp"
+#include "../src/engine.hpp"
+#include "../src/moves.hpp"
 #include "../src/miscellaneous.hpp"
 
 TEST_CASE("FEN set->generate", "[fen]")
 {
   bitboard::init();
 
-  pool.set(1);
+  Engine engine{};
 
   Board b{};
-  b.set_fen(start_position, pool.main());
+  b.set_fen(start_position, engine.pool.main());
 
   const auto fen = b.fen();
 
@@ -49,3 +51,43 @@ TEST_CASE("FEN set->generate", "[fen]")
   REQUIRE(equals);
 
 }
+
+TEST_CASE("Key after move", "[key_after]")
+{
+  bitboard::init();
+  Board::init();
+
+  Engine engine{};
+
+  // castling, en-passant, promotions and captures of castling rooks
+  constexpr std::array<std::string_view, 3> fens{
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"};
+
+  for (const auto fen : fens)
+  {
+    Board b{};
+    b.set_fen(fen, engine.pool.main());
+
+    for (const auto &move_data : MoveList<LEGALMOVES>(&b))
+    {
+      const auto m        = move_data.move;
+      const auto key      = b.key_after(m);
+      const auto pawn_key = b.pawn_key_after(m);
+
+      if (!b.make_move(m, true, true))
+        continue;
+
+      REQUIRE(b.key() == key);
+      REQUIRE(b.pawn_key() == pawn_key);
+
+      b.unmake_move();
+    }
+
+    const auto null_key = b.key_after(MOVE_NONE);
+    b.make_null_move();
+
+    REQUIRE(b.key() == null_key);
+  }
+}
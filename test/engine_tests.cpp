@@ -0,0 +1,261 @@
+/*
+  Feliscatus, a UCI chess playing engine derived from Tomcat 1.0 (Bobcat 8.0)
+  Copyright (C) 2008-2016 Gunnar Harms (Bobcat author)
+  Copyright (C) 2017      FireFather (Tomcat author)
+  Copyright (C) 2020-2022 Rudy Alex Kohn
+
+  Feliscatus is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Feliscatus is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define CATCH_CONFIG_MAIN
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+
+#include "../src/bitboard.hpp"
+#include "../src/board.hpp"
+#include "../src/engine.hpp"
+#include "../src/moves.hpp"
+
+TEST_CASE("Engines search independently", "[engine]")
+{
+  bitboard::init();
+  Board::init();
+
+  constexpr std::string_view fen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10";
+
+  SearchLimits limits;
+  limits.depth       = 7;
+  limits.fixed_depth = true;
+
+  Engine single{};
+  const auto expected = single.search(fen, limits);
+
+  REQUIRE(expected.best_move != MOVE_NONE);
+  REQUIRE(expected.depth == limits.depth);
+
+  // each engine has its own table and threads, so searching at the same time gives the same result as alone
+  Engine first{};
+  Engine second{};
+
+  first.start(fen, limits);
+  second.start(fen, limits);
+
+  const auto first_result  = first.wait();
+  const auto second_result = second.wait();
+
+  REQUIRE(first_result.best_move == expected.best_move);
+  REQUIRE(first_result.nodes == expected.nodes);
+  REQUIRE(second_result.best_move == expected.best_move);
+  REQUIRE(second_result.nodes == expected.nodes);
+}
+
+TEST_CASE("MultiPV searches more lines than there are moves", "[engine]")
+{
+  bitboard::init();
+  Board::init();
+
+  SearchLimits limits;
+  limits.depth       = 7;
+  limits.fixed_depth = true;
+
+  EngineConfig config;
+  config.multi_pv = 4;
+
+  Engine engine{config};
+
+  // the lines are ranked by score and each starts with its own move
+  const auto check_lines = [](const SearchResult &result) {
+    REQUIRE(std::ranges::is_sorted(result.lines, std::ranges::greater{}, &SearchLine::score));
+    REQUIRE(result.lines.front().pv.front() == result.best_move);
+
+    std::vector<Move> first_moves;
+
+    for (const auto &[score, pv] : result.lines)
+    {
+      REQUIRE_FALSE(pv.empty());
+      first_moves.emplace_back(pv.front());
+    }
+
+    std::ranges::sort(first_moves);
+    REQUIRE(std::ranges::adjacent_find(first_moves) == first_moves.end());
+  };
+
+  // the king has two moves, so only two lines are searched
+  const auto result = engine.search("7k/8/8/8/8/8/8/K6r w - - 0 1", limits);
+
+  REQUIRE(result.best_move != MOVE_NONE);
+  REQUIRE(result.depth == limits.depth);
+  REQUIRE(result.lines.size() == 2);
+  check_lines(result);
+
+  const auto kiwipete = engine.search("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10", limits);
+
+  REQUIRE(kiwipete.best_move != MOVE_NONE);
+  REQUIRE(kiwipete.depth == limits.depth);
+  REQUIRE(kiwipete.lines.size() == 4);
+  check_lines(kiwipete);
+}
+
+TEST_CASE("MultiPV searches stopped inside an iteration keep the best line", "[engine]")
+{
+  bitboard::init();
+  Board::init();
+
+  EngineConfig config;
+  config.multi_pv = 3;
+
+  Engine engine{config};
+
+  // the node limit stops the search at a different line of an iteration each time, the first line of the
+  // interrupted iteration or the last completed one is restored and stored in the table
+  for (std::uint64_t nodes = 500; nodes <= 20000; nodes += 750)
+  {
+    SearchLimits limits;
+    limits.nodes = nodes;
+
+    const auto result = engine.search("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10", limits);
+
+    REQUIRE(result.best_move != MOVE_NONE);
+    REQUIRE(result.lines.size() == 3);
+    REQUIRE(std::ranges::all_of(result.lines, [](const SearchLine &line) { return !line.pv.empty(); }));
+  }
+}
+
+TEST_CASE("Search moves restrict the root", "[engine]")
+{
+  bitboard::init();
+  Board::init();
+
+  constexpr std::string_view fen = "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19";
+
+  SearchLimits limits;
+  limits.depth       = 7;
+  limits.fixed_depth = true;
+
+  Engine engine{};
+
+  const auto best = engine.search(fen, limits);
+
+  REQUIRE(best.best_move != MOVE_NONE);
+
+  // every move but the best one
+  Board b{};
+  b.set_fen(fen, engine.pool.main());
+
+  for (const auto &move_data : MoveList<LEGALMOVES>(&b))
+    if (move_data.move != best.best_move)
+      limits.search_moves.emplace_back(move_data.move);
+
+  const auto restricted = engine.search(fen, limits);
+
+  REQUIRE(restricted.best_move != MOVE_NONE);
+  REQUIRE(restricted.best_move != best.best_move);
+  REQUIRE(std::ranges::find(limits.search_moves, restricted.best_move) != limits.search_moves.end());
+}
+
+TEST_CASE("Node limited searches are reproducible", "[engine]")
+{
+  bitboard::init();
+  Board::init();
+
+  constexpr std::string_view fen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10";
+
+  SearchLimits limits;
+  limits.nodes = 100000;
+
+  Engine first{};
+  Engine second{};
+
+  const auto first_result  = first.search(fen, limits);
+  const auto second_result = second.search(fen, limits);
+
+  REQUIRE(first_result.best_move != MOVE_NONE);
+  REQUIRE(first_result.nodes >= limits.nodes);
+  REQUIRE(first_result.nodes < limits.nodes + 16);
+  REQUIRE(second_result.best_move == first_result.best_move);
+  REQUIRE(second_result.nodes == first_result.nodes);
+}
+
+TEST_CASE("Node limit holds for all threads of the pool", "[engine]")
+{
+  bitboard::init();
+  Board::init();
+
+  constexpr std::string_view fen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10";
+
+  SearchLimits limits;
+  limits.nodes = 100000;
+
+  for (const std::size_t threads : {2, 4, 8})
+  {
+    EngineConfig config;
+    config.threads = threads;
+
+    Engine engine{config};
+
+    const auto result = engine.search(fen, limits);
+
+    // the threads claim the nodes in chunks of 128, a thread can stop with part of its chunk unused, and each thread
+    // searches a node or two after the limit before it sees the stop
+    REQUIRE(result.best_move != MOVE_NONE);
+    REQUIRE(result.nodes + threads * 128 >= limits.nodes);
+    REQUIRE(result.nodes < limits.nodes + threads * 16);
+  }
+}
+
+TEST_CASE("Mate limited search ends at the mate", "[engine]")
+{
+  bitboard::init();
+  Board::init();
+
+  SearchLimits limits;
+  limits.mate = 2;
+
+  Engine engine{};
+
+  // the king has to come closer before the rook mates
+  const auto result = engine.search("7k/8/5K2/8/8/8/8/R7 w - - 0 1", limits);
+
+  REQUIRE(result.best_move != MOVE_NONE);
+  REQUIRE(result.score == 32767 - 3);
+}
+
+TEST_CASE("Ponder hit turns the ponder search into a timed search", "[engine]")
+{
+  bitboard::init();
+  Board::init();
+
+  SearchLimits limits;
+  limits.ponder = true;
+  limits.time.fill(10000);
+
+  Engine engine{};
+
+  engine.start("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10", limits);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // the search keeps what it has found while pondering and ends on its own clock
+  engine.ponder_hit();
+
+  const auto result = engine.wait();
+
+  REQUIRE(result.best_move != MOVE_NONE);
+  REQUIRE(result.depth > 1);
+}
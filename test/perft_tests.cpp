@@ -22,23 +22,21 @@
 
 #include <catch2/catch_all.hpp>
 
-#include "../src/transpositional.hpp"
 #include "../src/bitboard.hpp"
 #include "../src/perft.hpp"
 #include "../src/board.hpp"
 #include "../src/miscellaneous.hpp"
-#include "../src/tpool.hpp"
+#include "../src/engine.hpp"
 
 TEST_CASE("Perft basic", "[perft_basic]")
 {
-  TT.init(1);
   bitboard::init();
   Board::init();
 
-  pool.set(1);
+  Engine engine{};
 
   Board b{};
-  b.set_fen(start_position, pool.main());
+  b.set_fen(start_position, engine.pool.main());
 
   std::uint64_t result = 0;
 
@@ -65,3 +63,26 @@ TEST_CASE("Perft basic", "[perft_basic]")
 
 //  REQUIRE(result == 124132536);
 }
+
+TEST_CASE("Perft castling through attacked squares", "[perft_castling]")
+{
+  bitboard::init();
+  Board::init();
+
+  Engine engine{};
+
+  // positions where castling is often blocked by an attacked square on the path of the king
+  Board b{};
+
+  SECTION("Kiwipete depth=3")
+  {
+    b.set_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", engine.pool.main());
+    REQUIRE(perft::perft(&b, 3) == 48 + 2039 + 97862);
+  }
+
+  SECTION("Mirrored castling depth=3")
+  {
+    b.set_fen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", engine.pool.main());
+    REQUIRE(perft::perft(&b, 3) == 6 + 264 + 9467);
+  }
+}
@@ -0,0 +1,197 @@
+/*
+  Feliscatus, a UCI chess playing engine derived from Tomcat 1.0 (Bobcat 8.0)
+  Copyright (C) 2008-2016 Gunnar Harms (Bobcat author)
+  Copyright (C) 2017      FireFather (Tomcat author)
+  Copyright (C) 2020-2022 Rudy Alex Kohn
+
+  Feliscatus is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Feliscatus is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define CATCH_CONFIG_MAIN
+
+#include <filesystem>
+
+#include <catch2/catch_all.hpp>
+
+#include "../src/transpositional.hpp"
+
+TEST_CASE("TT insert->find", "[tt_insert_find]")
+{
+  HashTable tt;
+  tt.init(1);
+
+  constexpr Key key   = 0x9d39247e33776d41ull;
+  constexpr auto move = init_move<CAPTURE>(W_KNIGHT, B_PAWN, C3, D5, NO_PIECE);
+
+  tt.insert(key, 12, -345, BETA, move, -1200);
+
+  const auto entry = tt.find(key);
+
+  REQUIRE(entry.has_value());
+  REQUIRE(entry->depth() == 12);
+  REQUIRE(entry->score() == -345);
+  REQUIRE(entry->eval() == -1200);
+  REQUIRE(entry->move() == move);
+  REQUIRE(entry->flags() == BETA);
+  REQUIRE(entry->is_beta());
+
+  SECTION("Same key without move keeps the stored move")
+  {
+    tt.insert(key, 13, 20, EXACT, MOVE_NONE, 10);
+    const auto updated = tt.find(key);
+
+    REQUIRE(updated.has_value());
+    REQUIRE(updated->move() == move);
+    REQUIRE(updated->is_exact());
+  }
+
+  SECTION("Unknown key is a miss")
+  {
+    REQUIRE_FALSE(tt.find(key ^ 0xffffffff00000000ull).has_value());
+  }
+}
+
+TEST_CASE("TT resize keeps entries", "[tt_resize]")
+{
+  HashTable tt;
+  tt.init(2);
+  tt.clear();
+
+  std::array<Key, 1000> keys{};
+  auto key = 0x9d39247e33776d41ull;
+
+  for (auto &k : keys)
+  {
+    // xorshift for spread out keys
+    key ^= key << 13;
+    key ^= key >> 7;
+    key ^= key << 17;
+    k = key;
+    tt.insert(k, 7, 42, EXACT, MOVE_NONE, 0);
+  }
+
+  const auto found = [&keys, &tt] {
+    return std::ranges::count_if(keys, [&tt](const Key k) { return tt.find(k).has_value(); });
+  };
+
+  const auto stored = found();
+
+  SECTION("Grow")
+  {
+    tt.init(5);
+    REQUIRE(found() >= stored - 2);
+  }
+
+  SECTION("Shrink")
+  {
+    tt.init(1);
+    REQUIRE(found() >= stored - 2);
+  }
+}
+
+TEST_CASE("TT background clear", "[tt_clear_async]")
+{
+  HashTable tt;
+  tt.init(1);
+
+  constexpr Key old_key = 0x9d39247e33776d41ull;
+  constexpr Key new_key = 0x2af7398005aaa5c7ull;
+
+  tt.insert(old_key, 5, 10, EXACT, MOVE_NONE, 0);
+  tt.clear_async();
+
+  REQUIRE_FALSE(tt.find(old_key).has_value());
+
+  tt.insert(new_key, 5, 10, EXACT, MOVE_NONE, 0);
+  tt.wait_for_clear();
+
+  REQUIRE_FALSE(tt.find(old_key).has_value());
+  REQUIRE(tt.find(new_key).has_value());
+}
+
+TEST_CASE("TT background clear after the generation wraps", "[tt_clear_async]")
+{
+  HashTable tt;
+  tt.init(1);
+
+  constexpr Key old_key = 0x9d39247e33776d41ull;
+  constexpr Key new_key = 0x2af7398005aaa5c7ull;
+
+  tt.insert(old_key, 5, 10, EXACT, MOVE_NONE, 0);
+
+  // the clear starts a new generation, after 32 the old entry has the current generation again
+  for (auto i = 0; i < 31; ++i)
+    tt.init_search();
+
+  tt.clear_async();
+
+  REQUIRE_FALSE(tt.find(old_key).has_value());
+
+  tt.insert(new_key, 5, 10, EXACT, MOVE_NONE, 0);
+  tt.wait_for_clear();
+
+  REQUIRE_FALSE(tt.find(old_key).has_value());
+  REQUIRE(tt.find(new_key).has_value());
+}
+
+TEST_CASE("TT snapshot save and load", "[tt_snapshot]")
+{
+  HashTable tt;
+  tt.init(2);
+  tt.clear();
+
+  std::array<Key, 1000> keys{};
+  auto key = 0x9d39247e33776d41ull;
+
+  for (auto &k : keys)
+  {
+    key ^= key << 13;
+    key ^= key >> 7;
+    key ^= key << 17;
+    k = key;
+    tt.insert(k, 9, 17, EXACT, MOVE_NONE, 3);
+  }
+
+  const auto found = [&keys](const HashTable &table) {
+    return std::ranges::count_if(keys, [&table](const Key k) {
+      const auto entry = table.find(k);
+      return entry.has_value() && entry->depth() == 9 && entry->score() == 17;
+    });
+  };
+
+  const auto stored = found(tt);
+  const auto path   = (std::filesystem::temp_directory_path() / "feliscatus_tt_tests.hash").string();
+
+  REQUIRE(tt.save_file(path));
+
+  SECTION("Same size")
+  {
+    HashTable loaded;
+    loaded.init(2);
+
+    REQUIRE(loaded.load_file(path));
+    REQUIRE(found(loaded) == stored);
+  }
+
+  SECTION("Different size")
+  {
+    HashTable loaded;
+    loaded.init(4);
+
+    REQUIRE(loaded.load_file(path));
+    REQUIRE(found(loaded) >= stored - 2);
+  }
+
+  std::filesystem::remove(path);
+}
@@ -20,10 +20,14 @@
 
 #define CATCH_CONFIG_MAIN
 
+#include <memory>
+
 #include <catch2/catch_all.hpp>
 
 #include "../src/util.hpp"
 #include "../src/types.hpp"
+#include "../src/pv_entry.hpp"
+#include "../src/hash.hpp"
 
 TEST_CASE("Abs test", "[abs]")
 {
@@ -66,3 +70,70 @@ TEST_CASE("in_between negative test", "[in_between_negative]")
 
   REQUIRE(actual == expected);
 }
+
+TEST_CASE("PV table keeps the line of every ply", "[pv_table]")
+{
+  auto table = std::make_unique<PVTable>();
+
+  const auto entry_key = [](const std::size_t ply, const std::size_t i) -> Key {
+    return ply << 16 | i;
+  };
+
+  // the lines share one triangular array, filling all of them must not overwrite another line
+  for (std::size_t ply = 0; ply < MAXDEPTH; ++ply)
+  {
+    for (auto i = ply; i < MAXDEPTH; ++i)
+    {
+      auto &entry = (*table)[ply][i];
+      entry.key   = entry_key(ply, i);
+      entry.move  = static_cast<Move>(i);
+    }
+  }
+
+  for (std::size_t ply = 0; ply < MAXDEPTH; ++ply)
+  {
+    for (auto i = ply; i < MAXDEPTH; ++i)
+    {
+      REQUIRE((*table)[ply][i].key == entry_key(ply, i));
+      REQUIRE((*table)[ply][i].move == static_cast<Move>(i));
+    }
+  }
+
+  REQUIRE(table->front()[MAXDEPTH - 1].key == entry_key(0, MAXDEPTH - 1));
+}
+
+TEST_CASE("Table keeps an entry per slot", "[table]")
+{
+  struct Entry final
+  {
+    Key key;
+    int value;
+  };
+
+  Table<Entry> table;
+  table.resize(1);
+
+  const auto slots = table.bytes() / sizeof(Entry);
+
+  REQUIRE(std::has_single_bit(slots));
+  REQUIRE(table.bytes() <= 1024 * 1024);
+
+  for (Key key = 0; key < slots; ++key)
+    *table[key] = Entry{key, static_cast<int>(key) * 3};
+
+  for (Key key = 0; key < slots; ++key)
+  {
+    REQUIRE(table[key]->key == key);
+    REQUIRE(table[key]->value == static_cast<int>(key) * 3);
+  }
+
+  // only the lower bits of the key select the slot
+  REQUIRE(table[slots + 5] == table[5]);
+  REQUIRE(table[Key{1} << 40 | 7]->key == 7);
+
+  // a table too small for a single entry still has one slot
+  table.resize(0);
+
+  REQUIRE(table.bytes() == sizeof(Entry));
+  REQUIRE(table[42] == table[7]);
+}
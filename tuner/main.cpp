@@ -29,8 +29,7 @@
 #include "tune.hpp"
 #include "../src/board.hpp"
 #include "../src/bitboard.hpp"
-#include "../src/transpositional.hpp"
-#include "../src/tpool.hpp"
+#include "../src/engine.hpp"
 #include "../cli/cli_parser.hpp"
 #include "../src/parameters.hpp"
 
@@ -55,14 +54,15 @@ int main(const int argc, char **argv)
 
   const auto cli_parser_settings = cli::make_parser(argc, argv, title, ParserType::Tuner);
 
-  TT.init(256);
   params::init();
 
   bitboard::init();
   Board::init();
 
+  Engine engine{};
+
   const Stopwatch sw;
-  eval::Tune(std::make_unique<Board>(), cli_parser_settings.get());
+  eval::Tune(std::make_unique<Board>(), engine.pool.main(), cli_parser_settings.get());
   const auto seconds = sw.elapsed_seconds();
   fmt::print("{} seconds\n", seconds);
 }
@@ -31,6 +31,9 @@
 namespace
 {
 
+// the length of a game is not known before it has been read, so the board has room for a long one
+constexpr std::size_t max_game_plies = 2048;
+
 constexpr auto detect_piece = [](const int from) {
   switch (from)
   {
@@ -63,12 +66,13 @@ bool strieq(const char *s1, const char *s2)
 
 }   // namespace
 
-pgn::PGNPlayer::PGNPlayer([[maybe_unused]] bool check_legal) : PGNFileReader(), b(std::make_unique<Board>())
+pgn::PGNPlayer::PGNPlayer(thread *search_thread, [[maybe_unused]] bool check_legal)
+  : PGNFileReader(), b(std::make_unique<Board>(max_game_plies)), t(search_thread)
 { }
 
 void pgn::PGNPlayer::read_pgn_game()
 {
-  b->new_game(pool.main());
+  b->new_game(t);
   pgn::PGNFileReader::read_pgn_game();
 }
 
@@ -79,7 +83,7 @@ void pgn::PGNPlayer::read_tag_pair()
   if (strieq(tag_name_, "FEN"))
   {
     const auto fen = std::string(tag_value_).substr(1, strlen(tag_value_) - 2);
-    b->set_fen(fen, pool.main());
+    b->set_fen(fen, t);
   }
 }
 
@@ -25,6 +25,7 @@
 #include "pgn.hpp"
 
 struct Board;
+struct thread;
 
 namespace pgn
 {
@@ -32,7 +33,7 @@ namespace pgn
 struct PGNPlayer : PGNFileReader
 {
 
-  explicit PGNPlayer(bool check_legal = true);
+  explicit PGNPlayer(thread *t, bool check_legal = true);
 
   virtual ~PGNPlayer() = default;
 
@@ -44,5 +45,6 @@ struct PGNPlayer : PGNFileReader
 
 protected:
   std::unique_ptr<Board> b;
+  thread *t;
 };
 }   // namespace pgn
\ No newline at end of file
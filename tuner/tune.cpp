@@ -382,7 +382,7 @@ void init_eval(std::vector<eval::Param> &params, const ParserSettings *settings)
 namespace eval
 {
 
-PGNPlayer::PGNPlayer() : pgn::PGNPlayer()
+PGNPlayer::PGNPlayer(thread *search_thread) : pgn::PGNPlayer(search_thread)
 { }
 
 void PGNPlayer::read_pgn_database()
@@ -429,9 +429,10 @@ void PGNPlayer::print_progress(const bool force) const
     all_selected_nodes_.size());
 }
 
-Tune::Tune(std::unique_ptr<Board> board, const ParserSettings *settings) : b(std::move(board)), score_static_(false)
+Tune::Tune(std::unique_ptr<Board> board, thread *search_thread, const ParserSettings *settings)
+  : b(std::move(board)), t(search_thread), score_static_(false)
 {
-  PGNPlayer pgn;
+  PGNPlayer pgn(t);
   pgn.read(settings->file_name);
 
   // Tuning as described in https://www.chessprogramming.org/Texel%27s_Tuning_Method
@@ -556,7 +557,7 @@ double Tune::e(
 
   for (const auto &node : nodes)
   {
-    b->set_fen(node.fen_, pool.main());
+    b->set_fen(node.fen_, t);
     const auto z = node.result_ - util::sigmoid(score(WHITE), K);
     x += z * z;
   }
@@ -579,7 +580,6 @@ double Tune::e(
 
 void Tune::make_quiet(std::vector<Node> &nodes)
 {
-  auto *t = pool.main();
   for (auto &node : nodes)
   {
     b->set_fen(node.fen_, t);
@@ -662,14 +662,12 @@ void Tune::unmake_move() const
 
 void Tune::play_pv() const
 {
-  auto *t = b->my_thread();
   for (auto i = 0; i < t->pv_length[0]; ++i)
     b->make_move(t->pv[0][i].move, false, true);
 }
 
 void Tune::update_pv(const Move m, const int score, const int ply) const
 {
-  auto *t = b->my_thread();
   assert(ply < MAXDEPTH);
   assert(t->pv_length[ply] < MAXDEPTH);
   auto *entry = &t->pv[ply][ply];
@@ -46,7 +46,7 @@ struct ParamIndexRecord;
 class PGNPlayer : public pgn::PGNPlayer
 {
 public:
-  PGNPlayer();
+  explicit PGNPlayer(thread *search_thread);
 
   virtual ~PGNPlayer() = default;
 
@@ -69,7 +69,7 @@ private:
 
 class Tune final {
 public:
-  explicit Tune(std::unique_ptr<Board> board, const ParserSettings *settings);
+  explicit Tune(std::unique_ptr<Board> board, thread *search_thread, const ParserSettings *settings);
 
   double
     e(const std::vector<Node> &nodes, const std::vector<Param> &params,
@@ -91,6 +91,7 @@ public:
 
 private:
   std::unique_ptr<Board> b;
+  thread *t;
   bool score_static_;
 };
 